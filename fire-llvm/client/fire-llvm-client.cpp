@@ -0,0 +1,21 @@
+#include <iostream>
+
+#include <fire-llvm/runtime/serve.hpp>
+
+// Thin client for CLIs running with --fire-serve=<socket>. Unlike invoking the
+// CLI itself, this does not construct any of the CLI's global objects.
+int main(int argc, char **argv)
+{
+  if (argc < 2) {
+    std::cerr << "usage: " << argv[0] << " <socket> [<args>...]\n";
+    return 1;
+  }
+
+  try {
+    return fire::runtime::run_client(argv[1], argc - 2, argv + 2);
+
+  } catch (fire::runtime::error const &e) {
+    std::cerr << argv[0] << ": error: " << e.what() << "\n";
+    return 1;
+  }
+}
@@ -1,10 +1,25 @@
 #pragma once
 
-#include <fire-hpp/fire.hpp>
+#include <fire-llvm/runtime/args.hpp>
+#include <fire-llvm/runtime/async.hpp>
+#include <fire-llvm/runtime/convert.hpp>
+#include <fire-llvm/runtime/dispatch.hpp>
+#include <fire-llvm/runtime/launch.hpp>
+#include <fire-llvm/runtime/output.hpp>
+#include <fire-llvm/runtime/overload.hpp>
+#include <fire-llvm/parser.hpp>
+#include <fire-llvm/stream.hpp>
+#include <fire-llvm/task.hpp>
 
 namespace fire {
 
 template<typename T>
 void fire_llvm(T&&) {}
 
+// Fires a class that is only constructed once a command has been dispatched
+// and its arguments are valid, constructor parameters become options of
+// every command.
+template<typename T>
+void fire_llvm() {}
+
 } // end namespace fire
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string_view>
+
+namespace fire {
+
+// Customization point for parameter types without a built-in conversion. A
+// specialization provides
+//
+//   static bool parse(std::string_view value, T &result);
+//
+// which converts value into a default constructed result and returns whether
+// value was valid. Alternatively, a function
+//
+//   bool fire_parse(std::string_view value, T &result);
+//
+// with the same semantics can be declared next to T, where it is found by
+// argument dependent lookup. value refers directly to the command line, no
+// strings are allocated to call either of them.
+template<typename T>
+struct parser;
+
+} // end namespace fire
@@ -0,0 +1,429 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iostream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <fire-llvm/runtime/profile.hpp>
+
+namespace fire::runtime {
+
+class error : public std::runtime_error
+{
+public:
+  using std::runtime_error::runtime_error;
+};
+
+enum class param_kind
+{
+  flag,     // -f, --flag[=<bool>]
+  value,    // -x=<value>, -x <value>
+  variadic  // all positional arguments
+};
+
+// Schema entry of a single launchpad parameter, emitted by the plugin as a
+// constexpr table so that neither binding nor usage messages need to
+// construct anything at runtime.
+struct param
+{
+  std::string_view name;
+  param_kind kind;
+
+  // Name of the accepted values in usage messages, e.g. "int".
+  std::string_view type = {};
+
+  // Default argument as written in the source, empty if there is none.
+  std::string_view default_value = {};
+
+  // Parameter documentation, taken from the function's doc comment.
+  std::string_view help = {};
+
+  // Whether the option must be given.
+  bool required = false;
+};
+
+// Schema entry of a single command of a fired class.
+struct command
+{
+  std::string_view name;
+
+  // Brief method documentation, taken from the method's doc comment.
+  std::string_view help = {};
+};
+
+inline void print_padding(std::ostream &os, std::size_t width)
+{
+  for (std::size_t i { 0 }; i < width; ++i)
+    os.put(' ');
+}
+
+// Argument bound to the parameter at the same position in the schema.
+struct slot
+{
+  std::string_view value;
+  bool present = false;
+};
+
+// Command line arguments, tokenized exactly once. Launchpads bind the
+// remaining tokens to their parameter slots, values are never copied out of
+// the argument strings themselves, std::string_view parameters refer to
+// them directly.
+class args
+{
+public:
+  // Arguments before first (except the program name) are skipped.
+  args(int argc, char const *const *argv, int first = 1)
+  {
+    tokens_.reserve(argc);
+    for (int i { 0 }; i < argc; ++i) {
+      if (i == 0 || i >= first)
+        tokens_.emplace_back(argv[i]);
+    }
+
+    positionals_.resize(tokens_.size());
+
+    profile().mark(phase::parse);
+  }
+
+  // Tokens of a command line that was split by the runtime itself, the first
+  // token is the program name.
+  explicit args(std::vector<std::string_view> tokens)
+  : tokens_(std::move(tokens)),
+    positionals_(tokens_.size())
+  {
+    profile().mark(phase::parse);
+  }
+
+  std::string_view program() const noexcept
+  { return tokens_.empty() ? std::string_view() : tokens_[0]; }
+
+  std::string_view command() const noexcept
+  { return command_; }
+
+  // Consumes the next token if it is a command name, otherwise returns an
+  // empty string.
+  std::string_view shift() noexcept
+  {
+    if (next_ == tokens_.size() || is_option(tokens_[next_]))
+      return std::string_view();
+
+    command_ = tokens_[next_++];
+
+    return command_;
+  }
+
+  bool help_requested() const noexcept
+  {
+    for (auto i { next_ }; i < tokens_.size(); ++i) {
+      if (tokens_[i] == "--")
+        break;
+
+      if (tokens_[i] == "-h" || tokens_[i] == "--help")
+        return true;
+    }
+
+    return false;
+  }
+
+  // Binds all remaining tokens to slots in a single pass. Returns false if
+  // help was requested instead, in which case the usage message is printed.
+  template<std::size_t num_params>
+  bool bind(std::array<param, num_params> const &params,
+            std::array<slot, num_params> &slots,
+            std::string_view help = {})
+  {
+    profile().mark(phase::dispatch);
+
+    num_positionals_ = 0;
+
+    bool options_done { false };
+
+    for (auto i { next_ }; i < tokens_.size(); ++i) {
+      auto token { tokens_[i] };
+
+      if (options_done || !is_option(token)) {
+        positionals_[num_positionals_++] = token;
+        continue;
+      }
+
+      if (token == "--") {
+        options_done = true;
+        continue;
+      }
+
+      auto name { token };
+      std::string_view value;
+      bool has_value { false };
+
+      if (auto eq { token.find('=') }; eq != std::string_view::npos) {
+        name = token.substr(0, eq);
+        value = token.substr(eq + 1);
+        has_value = true;
+      }
+
+      auto p { find(params, name) };
+
+      if (p == num_params) {
+        if (name == "-h" || name == "--help") {
+          print_usage(std::cout, params, help);
+          return false;
+        }
+
+        throw error("unknown option '" + std::string(name) + "'");
+      }
+
+      auto &s { slots[p] };
+
+      if (s.present)
+        throw error("option '" + std::string(name) + "' given more than once");
+
+      s.present = true;
+
+      if (params[p].kind == param_kind::value && !has_value) {
+        if (i + 1 == tokens_.size())
+          throw error("option '" + std::string(name) + "' requires a value");
+
+        value = tokens_[++i];
+      }
+
+      s.value = value;
+    }
+
+    if (num_positionals_ > 0) {
+      auto p { find_variadic(params) };
+
+      if (p == num_params) {
+        throw error("unexpected argument '" +
+                    std::string(positionals_[0]) + "'");
+      }
+
+      slots[p].present = true;
+    }
+
+    return true;
+  }
+
+  // Options among the remaining tokens as a bit mask over params, with bit
+  // num_params set if there are also positional arguments.
+  template<std::size_t num_params>
+  unsigned long option_mask(std::array<param, num_params> const &params) const
+  {
+    unsigned long mask { 0 };
+
+    bool options_done { false };
+
+    for (auto i { next_ }; i < tokens_.size(); ++i) {
+      auto token { tokens_[i] };
+
+      if (options_done || !is_option(token)) {
+        mask |= 1ul << num_params;
+        continue;
+      }
+
+      if (token == "--") {
+        options_done = true;
+        continue;
+      }
+
+      auto eq { token.find('=') };
+      auto name { token.substr(0, eq) };
+
+      auto p { find(params, name) };
+
+      if (p == num_params)
+        throw error("unknown option '" + std::string(name) + "'");
+
+      mask |= 1ul << p;
+
+      if (params[p].kind == param_kind::value && eq == std::string_view::npos)
+        ++i;
+    }
+
+    return mask;
+  }
+
+  // Positional arguments bound by the last call to bind.
+  std::string_view const *positionals_begin() const noexcept
+  { return positionals_.data(); }
+
+  std::string_view const *positionals_end() const noexcept
+  { return positionals_.data() + num_positionals_; }
+
+  std::size_t num_positionals() const noexcept
+  { return num_positionals_; }
+
+  // Prints the program name followed by all commands shifted so far.
+  void print_usage_prefix(std::ostream &os) const
+  {
+    os << "usage:";
+
+    for (std::size_t i { 0 }; i < next_ && i < tokens_.size(); ++i)
+      os << " " << tokens_[i];
+  }
+
+  template<std::size_t num_params>
+  void print_usage(std::ostream &os,
+                   std::array<param, num_params> const &params,
+                   std::string_view help = {}) const
+  {
+    print_usage_prefix(os);
+
+    for (auto const &p : params) {
+      os << " ";
+
+      if (!p.required)
+        os << "[";
+
+      print_param(os, p);
+
+      if (!p.required)
+        os << "]";
+    }
+
+    os << "\n";
+
+    if (!help.empty())
+      os << "\n" << help << "\n";
+
+    if (num_params == 0)
+      return;
+
+    std::size_t width { 0 };
+    for (auto const &p : params)
+      width = std::max(width, param_width(p));
+
+    os << "\noptions:\n";
+
+    for (auto const &p : params) {
+      os << "  ";
+
+      print_param(os, p);
+
+      if (!p.help.empty() || !p.default_value.empty())
+        print_padding(os, width - param_width(p) + 2);
+
+      os << p.help;
+
+      if (!p.default_value.empty()) {
+        if (!p.help.empty())
+          os << " ";
+
+        os << "(default: " << p.default_value << ")";
+      }
+
+      os << "\n";
+    }
+  }
+
+private:
+  static void print_param(std::ostream &os, param const &p)
+  {
+    switch (p.kind) {
+    case param_kind::flag:
+      os << p.name;
+      break;
+    case param_kind::value:
+      os << p.name << "=<" << p.type << ">";
+      break;
+    case param_kind::variadic:
+      os << "<" << p.name << ">...";
+      break;
+    }
+  }
+
+  static std::size_t param_width(param const &p) noexcept
+  {
+    switch (p.kind) {
+    case param_kind::flag:
+      return p.name.size();
+    case param_kind::value:
+      return p.name.size() + p.type.size() + 3;
+    case param_kind::variadic:
+      return p.name.size() + 5;
+    }
+
+    return 0;
+  }
+
+  // Tokens starting with a dash are options, except for a lone dash and
+  // negative numbers, which are positional arguments. Anything else, e.g.
+  // -5x, is an option and rejected if no parameter has that name.
+  static bool is_option(std::string_view token) noexcept
+  {
+    if (token.size() < 2 || token[0] != '-')
+      return false;
+
+    return !is_negative_number(token);
+  }
+
+  // -<digits>[.<digits>][e[+-]<digits>], with at least one mantissa digit.
+  static bool is_negative_number(std::string_view token) noexcept
+  {
+    auto is_digit = [](char c) { return c >= '0' && c <= '9'; };
+
+    std::size_t i { 1 };
+    std::size_t num_digits { 0 };
+
+    for (; i < token.size() && is_digit(token[i]); ++i)
+      ++num_digits;
+
+    if (i < token.size() && token[i] == '.') {
+      for (++i; i < token.size() && is_digit(token[i]); ++i)
+        ++num_digits;
+    }
+
+    if (num_digits == 0)
+      return false;
+
+    if (i < token.size() && (token[i] == 'e' || token[i] == 'E')) {
+      if (++i < token.size() && (token[i] == '+' || token[i] == '-'))
+        ++i;
+
+      if (i == token.size() || !is_digit(token[i]))
+        return false;
+
+      while (i < token.size() && is_digit(token[i]))
+        ++i;
+    }
+
+    return i == token.size();
+  }
+
+  template<std::size_t num_params>
+  static std::size_t find(std::array<param, num_params> const &params,
+                          std::string_view name) noexcept
+  {
+    for (std::size_t p { 0 }; p < num_params; ++p) {
+      if (params[p].kind != param_kind::variadic && params[p].name == name)
+        return p;
+    }
+
+    return num_params;
+  }
+
+  template<std::size_t num_params>
+  static std::size_t find_variadic(std::array<param, num_params> const &params) noexcept
+  {
+    for (std::size_t p { 0 }; p < num_params; ++p) {
+      if (params[p].kind == param_kind::variadic)
+        return p;
+    }
+
+    return num_params;
+  }
+
+  std::vector<std::string_view> tokens_;
+  std::vector<std::string_view> positionals_;
+  std::size_t num_positionals_ = 0;
+  std::size_t next_ = 1;
+  std::string_view command_;
+};
+
+} // end namespace fire::runtime
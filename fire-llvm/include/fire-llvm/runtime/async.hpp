@@ -0,0 +1,152 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace fire {
+
+template<typename T>
+class task;
+
+} // end namespace fire
+
+namespace fire::runtime {
+
+// Small thread pool on which tasks and fire::async work are run. Threads are
+// only started once work is first posted, so programs that never use it do
+// not pay for it.
+class executor
+{
+public:
+  explicit executor(std::size_t num_threads =
+                      std::max(1u, std::thread::hardware_concurrency()))
+  : num_threads_(num_threads)
+  {}
+
+  executor(executor const &) = delete;
+  executor &operator=(executor const &) = delete;
+
+  ~executor()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+
+    work_available_.notify_all();
+
+    for (auto &thread : threads_)
+      thread.join();
+  }
+
+  void post(std::function<void()> work)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+
+      if (threads_.empty()) {
+        threads_.reserve(num_threads_);
+        for (std::size_t i { 0 }; i < num_threads_; ++i)
+          threads_.emplace_back([this]() { work_loop(); });
+      }
+
+      work_.push_back(std::move(work));
+    }
+
+    work_available_.notify_one();
+  }
+
+private:
+  void work_loop()
+  {
+    for (;;) {
+      std::function<void()> work;
+
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        work_available_.wait(lock, [this]() { return stopping_ || !work_.empty(); });
+
+        if (work_.empty())
+          return;
+
+        work = std::move(work_.front());
+        work_.pop_front();
+      }
+
+      work();
+    }
+  }
+
+  std::size_t num_threads_;
+  std::mutex mutex_;
+  std::condition_variable work_available_;
+  std::deque<std::function<void()>> work_;
+  std::vector<std::thread> threads_;
+  bool stopping_ = false;
+};
+
+inline executor &default_executor()
+{
+  static executor e;
+  return e;
+}
+
+template<typename T>
+struct is_task : std::false_type {};
+
+template<typename T>
+struct is_task<task<T>> : std::true_type {};
+
+template<typename T>
+struct is_async : is_task<T> {};
+
+template<typename T>
+struct is_async<std::future<T>> : std::true_type {};
+
+template<typename T>
+struct is_async<std::shared_future<T>> : std::true_type {};
+
+// Blocks until an asynchronous result is available and returns it.
+template<typename T>
+decltype(auto) await_result(T &&result)
+{
+  using async_type = std::decay_t<T>;
+
+  if constexpr (is_task<async_type>::value)
+    return async_type::sync_wait(std::forward<T>(result));
+  else
+    return result.get();
+}
+
+} // end namespace fire::runtime
+
+namespace fire {
+
+// Runs f(args...) on the default executor.
+template<typename F, typename... Args>
+auto async(F &&f, Args &&...args)
+{
+  using result_type = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
+
+  auto work { std::make_shared<std::packaged_task<result_type()>>(
+                std::bind(std::forward<F>(f), std::forward<Args>(args)...)) };
+
+  auto result { work->get_future() };
+
+  runtime::default_executor().post([work]() { (*work)(); });
+
+  return result;
+}
+
+} // end namespace fire
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdio>
+#include <exception>
+#include <iostream>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fire-llvm/runtime/args.hpp>
+#include <fire-llvm/runtime/output.hpp>
+#include <fire-llvm/runtime/profile.hpp>
+
+namespace fire::runtime {
+
+// Splits a command line into tokens like a POSIX shell would (without any
+// expansions): tokens are separated by whitespace, quotes group characters
+// and backslashes escape them. Quotes and escapes are removed in place, the
+// resulting tokens point into line.
+inline void split(std::string &line, std::vector<std::string_view> &tokens)
+{
+  auto out { line.begin() };
+  auto in { line.cbegin() };
+
+  while (in != line.cend()) {
+    if (*in == ' ' || *in == '\t' || *in == '\r') {
+      ++in;
+      continue;
+    }
+
+    auto token { out };
+    char quote { '\0' };
+
+    for (; in != line.cend(); ++in) {
+      if (quote == '\0' && (*in == ' ' || *in == '\t' || *in == '\r'))
+        break;
+
+      if (*in == quote) {
+        quote = '\0';
+      } else if (quote == '\0' && (*in == '"' || *in == '\'')) {
+        quote = *in;
+      } else if (*in == '\\' && quote != '\'' && in + 1 != line.cend()) {
+        *out++ = *++in;
+      } else {
+        *out++ = *in;
+      }
+    }
+
+    if (quote != '\0')
+      throw error("unterminated quote");
+
+    tokens.emplace_back(line.data() + (token - line.begin()), out - token);
+  }
+}
+
+// Runs entry once per non-empty line read from is, each result is terminated
+// by delimiter. Errors, including exceptions thrown by the fired function, are
+// reported on stderr and do not end the batch.
+template<typename F>
+int run_batch(std::string_view program,
+              F &&entry,
+              std::istream &is,
+              std::string_view delimiter)
+{
+  int status { 0 };
+
+  std::string line;
+  std::vector<std::string_view> tokens;
+
+  while (std::getline(is, line)) {
+    tokens.clear();
+    tokens.push_back(program);
+
+    try {
+      split(line, tokens);
+
+      // Skip empty lines.
+      if (tokens.size() == 1)
+        continue;
+
+      args a(tokens);
+
+      if (entry(a) != 0)
+        status = 1;
+
+    } catch (std::exception const &e) {
+      std::cerr << program << ": error: " << e.what() << "\n";
+      status = 1;
+    }
+
+    output().flush();
+
+    std::cout << delimiter;
+    std::cout.flush();
+
+    profile().mark(phase::output);
+  }
+
+  return status;
+}
+
+} // end namespace fire::runtime
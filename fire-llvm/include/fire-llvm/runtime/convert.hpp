@@ -0,0 +1,322 @@
+#pragma once
+
+#include <charconv>
+#include <cstdlib>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if __has_include(<span>)
+#include <span>
+#endif
+
+#include <fire-llvm/runtime/args.hpp>
+#include <fire-llvm/runtime/dispatch.hpp>
+#include <fire-llvm/runtime/file.hpp>
+
+namespace fire {
+
+template<typename T>
+class stream;
+
+template<typename T>
+struct parser;
+
+} // end namespace fire
+
+namespace fire::runtime {
+
+template<typename T>
+struct is_optional : std::false_type {};
+
+template<typename T>
+struct is_optional<std::optional<T>> : std::true_type {};
+
+template<typename T>
+struct is_vector : std::false_type {};
+
+template<typename T, typename A>
+struct is_vector<std::vector<T, A>> : std::true_type {};
+
+template<typename T>
+struct is_span : std::false_type {};
+
+#ifdef __cpp_lib_span
+template<typename T, std::size_t N>
+struct is_span<std::span<T, N>> : std::true_type {};
+#endif
+
+template<typename T>
+struct is_stream : std::false_type {};
+
+template<typename T>
+struct is_stream<stream<T>> : std::true_type {};
+
+template<typename T, typename = void>
+struct has_parser : std::false_type {};
+
+template<typename T>
+struct has_parser<T, std::void_t<decltype(parser<T>::parse(std::declval<std::string_view>(),
+                                                           std::declval<T &>()))>>
+: std::true_type {};
+
+template<typename T, typename = void>
+struct has_fire_parse : std::false_type {};
+
+template<typename T>
+struct has_fire_parse<T, std::void_t<decltype(fire_parse(std::declval<std::string_view>(),
+                                                         std::declval<T &>()))>>
+: std::true_type {};
+
+template<typename T>
+struct unsupported_type : std::false_type {};
+
+// Enumerators of an enumeration type, specialized by the plugin for every
+// enumeration used as a parameter type: a perfect hash table of their names
+// ('displacements' and 'slots', see lookup) and the enumerator stored in each
+// slot ('values').
+template<typename E>
+struct enum_names;
+
+[[noreturn]] inline void invalid_value(param const &p, std::string_view value)
+{
+  throw error("invalid value '" + std::string(value) + "' for " +
+              (p.kind == param_kind::variadic ? "argument '" : "option '") +
+              std::string(p.name) + "'");
+}
+
+template<typename T>
+T parse_number(param const &p, std::string_view value)
+{
+  auto first { value.data() };
+  auto last { value.data() + value.size() };
+
+  if (first != last && *first == '+')
+    ++first;
+
+  T result {};
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+  constexpr bool use_from_chars { true };
+#else
+  // Not every standard library implements floating point from_chars yet.
+  constexpr bool use_from_chars { std::is_integral_v<T> };
+#endif
+
+  if constexpr (use_from_chars) {
+    auto [ptr, ec] = std::from_chars(first, last, result);
+    if (ec != std::errc() || ptr != last || first == last)
+      invalid_value(p, value);
+
+  } else {
+    std::string number { first, last };
+
+    char *end { nullptr };
+
+    if constexpr (std::is_same_v<T, float>)
+      result = std::strtof(number.c_str(), &end);
+    else if constexpr (std::is_same_v<T, double>)
+      result = std::strtod(number.c_str(), &end);
+    else
+      result = std::strtold(number.c_str(), &end);
+
+    if (number.empty() || end != number.c_str() + number.size())
+      invalid_value(p, value);
+  }
+
+  return result;
+}
+
+template<typename T>
+T parse(param const &p, std::string_view value)
+{
+  if constexpr (std::is_same_v<T, std::string>) {
+    return std::string(value);
+
+  } else if constexpr (std::is_same_v<T, std::string_view>) {
+    return value;
+
+  } else if constexpr (std::is_same_v<T, bool>) {
+    if (value.empty() || value == "true" || value == "1")
+      return true;
+    if (value == "false" || value == "0")
+      return false;
+
+    invalid_value(p, value);
+
+  } else if constexpr (std::is_arithmetic_v<T>) {
+    return parse_number<T>(p, value);
+
+  } else if constexpr (std::is_enum_v<T>) {
+    using names = enum_names<T>;
+
+    auto slot { lookup(value, names::displacements, names::slots) };
+    if (value.empty() || slot == std::size(names::slots))
+      invalid_value(p, value);
+
+    return names::values[slot];
+
+  } else if constexpr (has_parser<T>::value || has_fire_parse<T>::value) {
+    T result {};
+
+    bool valid;
+    if constexpr (has_parser<T>::value)
+      valid = parser<T>::parse(value, result);
+    else
+      valid = fire_parse(value, result);
+
+    if (!valid)
+      invalid_value(p, value);
+
+    return result;
+
+  } else {
+    static_assert(unsupported_type<T>::value,
+                  "unsupported parameter type, specialize fire::parser or declare fire_parse");
+  }
+}
+
+inline bool is_delimiter(char c) noexcept
+{ return c == ' ' || c == '\n' || c == '\t' || c == '\r'; }
+
+// Counts whitespace separated tokens, written without loop carried
+// dependencies so that the compiler can vectorize it.
+inline std::size_t count_tokens(std::string_view content) noexcept
+{
+  if (content.empty())
+    return 0;
+
+  std::size_t num_tokens { !is_delimiter(content[0]) };
+
+  for (std::size_t i { 1 }; i < content.size(); ++i)
+    num_tokens += is_delimiter(content[i - 1]) & !is_delimiter(content[i]);
+
+  return num_tokens;
+}
+
+// Whether variadic parameters with elements of type T expand response files.
+template<typename T>
+inline constexpr bool has_response_files { std::is_arithmetic_v<T> || std::is_enum_v<T> };
+
+// Appends all whitespace separated elements of a response file to values.
+template<typename T>
+void read_response_file(param const &p,
+                        std::string_view path,
+                        std::vector<T> &values)
+{
+  mapped_file file { std::string(path) };
+
+  auto content { file.content() };
+
+  values.reserve(values.size() + count_tokens(content));
+
+  auto it { content.data() };
+  auto end { content.data() + content.size() };
+
+  for (;;) {
+    while (it != end && is_delimiter(*it))
+      ++it;
+
+    if (it == end)
+      break;
+
+    auto token { it };
+
+    while (it != end && !is_delimiter(*it))
+      ++it;
+
+    values.push_back(parse<T>(p, std::string_view(token, it - token)));
+  }
+}
+
+// Converts the argument bound to p. Flags that were not given are false,
+// optional parameters that were not given are empty and streams that were
+// not given read from stdin, all other parameters are required.
+template<typename T>
+T get(args const &a, param const &p, slot const &s)
+{
+  if constexpr (std::is_same_v<T, bool>) {
+    return s.present && parse<bool>(p, s.value);
+
+  } else if constexpr (is_optional<T>::value) {
+    if (!s.present)
+      return std::nullopt;
+
+    return parse<typename T::value_type>(p, s.value);
+
+  } else if constexpr (is_vector<T>::value) {
+    using value_type = typename T::value_type;
+
+    T values;
+    values.reserve(a.num_positionals());
+
+    for (auto it { a.positionals_begin() }; it != a.positionals_end(); ++it) {
+      auto value { *it };
+
+      // For numbers and enumerations, arguments of the form @<file> are read
+      // from response files, a leading @ can be escaped as @@. Strings are
+      // always taken as they are.
+      if constexpr (has_response_files<value_type>) {
+        if (value.size() > 1 && value[0] == '@') {
+          if (value[1] != '@') {
+            read_response_file(p, value.substr(1), values);
+            continue;
+          }
+
+          value.remove_prefix(1);
+        }
+      }
+
+      values.push_back(parse<value_type>(p, value));
+    }
+
+    return values;
+
+  } else if constexpr (is_span<T>::value) {
+    // Spans are bound to the positional arguments as they are, response
+    // files are not expanded.
+    static_assert(std::is_same_v<typename T::element_type, std::string_view const>,
+                  "only std::span<std::string_view const> is supported");
+
+    return T(a.positionals_begin(), a.num_positionals());
+
+  } else if constexpr (is_stream<T>::value) {
+    return T::open(p, s);
+
+  } else {
+    if (!s.present)
+      throw error("missing option '" + std::string(p.name) + "'");
+
+    return parse<T>(p, s.value);
+  }
+}
+
+// Like get but falls back to the parameter's default argument, which is only
+// evaluated if needed.
+template<typename T, typename F>
+T get(args const &a, param const &p, slot const &s, F &&default_value)
+{
+  if (!s.present)
+    return default_value();
+
+  return get<T>(a, p, s);
+}
+
+// Like get but empty if the argument was not given, leaving the default
+// argument to the caller. Used by split translation units, which can not
+// evaluate default arguments themselves.
+template<typename T>
+std::optional<T> get_if_present(args const &a, param const &p, slot const &s)
+{
+  if (!s.present)
+    return std::nullopt;
+
+  return get<T>(a, p, s);
+}
+
+} // end namespace fire::runtime
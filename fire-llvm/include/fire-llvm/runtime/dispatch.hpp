@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace fire::runtime {
+
+// Seeded FNV-1a followed by a final avalanche step so that the low bits of
+// the result depend on all input bits. The plugin builds perfect hash tables
+// with this same function, so it must never change independently of it.
+constexpr std::uint32_t hash(std::string_view key, std::uint32_t seed) noexcept
+{
+  std::uint32_t h { 2166136261u ^ seed };
+
+  for (char c : key) {
+    h ^= static_cast<unsigned char>(c);
+    h *= 16777619u;
+  }
+
+  h ^= h >> 16;
+  h *= 0x85ebca6bu;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35u;
+  h ^= h >> 16;
+
+  return h;
+}
+
+// Looks up key in a perfect hash table generated by the plugin. Returns the
+// slot index of key or num_slots if key is not contained in the table.
+template<std::size_t num_buckets, std::size_t num_slots>
+constexpr std::size_t lookup(std::string_view key,
+                             std::uint32_t const (&displacements)[num_buckets],
+                             std::string_view const (&slots)[num_slots]) noexcept
+{
+  auto displacement { displacements[hash(key, 0) % num_buckets] };
+  auto slot { hash(key, displacement) % num_slots };
+
+  return slots[slot] == key ? slot : num_slots;
+}
+
+} // end namespace fire::runtime
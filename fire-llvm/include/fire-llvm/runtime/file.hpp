@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <iterator>
+#endif
+
+#include <fire-llvm/runtime/args.hpp>
+
+namespace fire::runtime {
+
+// Read-only view of a complete file, memory mapped where possible.
+class mapped_file
+{
+public:
+  explicit mapped_file(std::string const &path)
+  {
+#if defined(__unix__) || defined(__APPLE__)
+    int fd { ::open(path.c_str(), O_RDONLY) };
+    if (fd < 0)
+      fail(path, errno);
+
+    struct stat st;
+    if (::fstat(fd, &st) < 0) {
+      int err { errno };
+      ::close(fd);
+      fail(path, err);
+    }
+
+    size_ = static_cast<std::size_t>(st.st_size);
+
+    if (size_ > 0) {
+      auto data { ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0) };
+      if (data == MAP_FAILED) {
+        int err { errno };
+        ::close(fd);
+        fail(path, err);
+      }
+
+      ::madvise(data, size_, MADV_SEQUENTIAL);
+
+      data_ = static_cast<char const *>(data);
+    }
+
+    ::close(fd);
+#else
+    std::ifstream is(path, std::ios::binary);
+    if (!is)
+      fail(path, errno);
+
+    content_.assign(std::istreambuf_iterator<char>(is),
+                    std::istreambuf_iterator<char>());
+
+    data_ = content_.data();
+    size_ = content_.size();
+#endif
+  }
+
+  mapped_file(mapped_file const &) = delete;
+  mapped_file &operator=(mapped_file const &) = delete;
+
+  ~mapped_file()
+  {
+#if defined(__unix__) || defined(__APPLE__)
+    if (data_)
+      ::munmap(const_cast<char *>(data_), size_);
+#endif
+  }
+
+  std::string_view content() const noexcept
+  { return std::string_view(data_, size_); }
+
+private:
+  // err has to be captured before any other call can overwrite errno.
+  [[noreturn]] static void fail(std::string const &path, int err)
+  { throw error("failed to read '" + path + "': " + std::strerror(err)); }
+
+  char const *data_ = nullptr;
+  std::size_t size_ = 0;
+
+#if !(defined(__unix__) || defined(__APPLE__))
+  std::string content_;
+#endif
+};
+
+} // end namespace fire::runtime
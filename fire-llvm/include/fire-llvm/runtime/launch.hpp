@@ -0,0 +1,135 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <fire-llvm/runtime/args.hpp>
+#include <fire-llvm/runtime/batch.hpp>
+#include <fire-llvm/runtime/output.hpp>
+#include <fire-llvm/runtime/profile.hpp>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define FIRE_LLVM_SERVE
+#include <fire-llvm/runtime/serve.hpp>
+#endif
+
+namespace fire::runtime {
+
+// Handles a command that did not match any of the commands of a launch entry.
+template<std::size_t num_commands>
+int no_command(args const &a,
+               std::string_view name,
+               std::array<command, num_commands> const &commands)
+{
+  if (name.empty()) {
+    if (a.help_requested()) {
+      a.print_usage_prefix(std::cout);
+
+      std::cout << " <command> [<args>...]\n\n"
+                << "commands:\n";
+
+      std::size_t width { 0 };
+      for (auto const &c : commands)
+        width = std::max(width, c.name.size());
+
+      for (auto const &c : commands) {
+        std::cout << "  " << c.name;
+
+        if (!c.help.empty()) {
+          print_padding(std::cout, width - c.name.size() + 2);
+          std::cout << c.help;
+        }
+
+        std::cout << "\n";
+      }
+
+      return 0;
+    }
+
+    throw error("missing command");
+  }
+
+  throw error("unknown command '" + std::string(name) + "'");
+}
+
+// Runs a launchpad or launch entry, reporting errors on stderr. Leading
+// runtime options select the output format (--fire-output=<format>, see
+// output_format) and whether entry is instead run once for every line read
+// from stdin (--fire-batch[=<delimiter>], the delimiter defaults to a NUL
+// byte, see run_batch) or for every request received on a Unix domain socket
+// (--fire-serve=<socket>, see run_server). --fire-profile[=<file>] reports
+// where time was spent (see profiler).
+template<typename F>
+int run(int argc, char const *const *argv, F &&entry)
+{
+  auto start { profiler::clock::now() };
+
+  std::string_view program { argc > 0 ? argv[0] : "" };
+
+  auto &out { output() };
+  auto &prof { profile() };
+
+  int status { 1 };
+
+  try {
+    std::optional<std::string_view> batch, serve;
+
+    int first { 1 };
+
+    for (; first < argc; ++first) {
+      std::string_view option { argv[first] };
+
+      auto value = [&option](std::string_view name) {
+        if (option.substr(0, name.size()) != name)
+          return false;
+
+        option.remove_prefix(name.size());
+        return true;
+      };
+
+      if (option == "--fire-batch")
+        batch = std::string_view("\0", 1);
+      else if (value("--fire-batch="))
+        batch = option;
+      else if (value("--fire-serve="))
+        serve = option;
+      else if (value("--fire-output="))
+        out.set_format(parse_output_format(option));
+      else if (option == "--fire-profile")
+        prof.enable(start);
+      else if (value("--fire-profile="))
+        prof.enable(start, option);
+      else
+        break;
+    }
+
+    if (batch) {
+      status = run_batch(program, entry, std::cin, *batch);
+#ifdef FIRE_LLVM_SERVE
+    } else if (serve) {
+      status = run_server(program, entry, *serve);
+#endif
+    } else {
+      args a(argc, argv, first);
+
+      status = entry(a);
+    }
+
+  } catch (error const &e) {
+    std::cerr << program << ": error: " << e.what() << "\n";
+  }
+
+  out.flush();
+
+  prof.mark(phase::output);
+  prof.report(std::cerr);
+
+  return status;
+}
+
+} // end namespace fire::runtime
@@ -0,0 +1,392 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if __has_include(<span>)
+#include <span>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+#include <fire-llvm/runtime/args.hpp>
+#include <fire-llvm/runtime/async.hpp>
+#include <fire-llvm/runtime/profile.hpp>
+
+namespace fire::runtime {
+
+enum class output_format
+{
+  text,   // operator<<, one result per line
+  jsonl,  // one JSON value per line, null for void results
+  binary  // raw values in host byte order, see write_binary
+};
+
+inline output_format parse_output_format(std::string_view format)
+{
+  if (format == "text")
+    return output_format::text;
+  if (format == "jsonl")
+    return output_format::jsonl;
+  if (format == "binary")
+    return output_format::binary;
+
+  throw error("invalid output format '" + std::string(format) + "'");
+}
+
+// Structured results are serialized into a large reusable buffer which is
+// written out with a single system call once it is full or flushed.
+class output_buffer
+{
+public:
+  static constexpr std::size_t capacity = 1 << 20;
+
+  output_buffer()
+  { buffer_.reserve(capacity); }
+
+  output_buffer(output_buffer const &) = delete;
+  output_buffer &operator=(output_buffer const &) = delete;
+
+  ~output_buffer()
+  { flush(); }
+
+  output_format format() const noexcept
+  { return format_; }
+
+  void set_format(output_format format) noexcept
+  { format_ = format; }
+
+  std::string &buffer() noexcept
+  { return buffer_; }
+
+  // Write to os instead of stdout until reset to nullptr.
+  void redirect(std::ostream *os)
+  {
+    flush();
+    target_ = os;
+  }
+
+  void flush_if_full()
+  {
+    if (buffer_.size() >= capacity)
+      flush();
+  }
+
+  void flush()
+  {
+    if (buffer_.empty())
+      return;
+
+    if (target_) {
+      target_->write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+      buffer_.clear();
+      return;
+    }
+
+    // Preserve the order of anything already written through iostreams.
+    std::cout.flush();
+    std::fflush(stdout);
+
+#if defined(__unix__) || defined(__APPLE__)
+    auto data { buffer_.data() };
+    auto size { buffer_.size() };
+
+    while (size > 0) {
+      auto n { ::write(STDOUT_FILENO, data, size) };
+      if (n <= 0)
+        break;
+
+      data += n;
+      size -= static_cast<std::size_t>(n);
+    }
+#else
+    std::fwrite(buffer_.data(), 1, buffer_.size(), stdout);
+    std::fflush(stdout);
+#endif
+
+    buffer_.clear();
+  }
+
+private:
+  output_format format_ = output_format::text;
+  std::string buffer_;
+  std::ostream *target_ = nullptr;
+};
+
+inline output_buffer &output()
+{
+  static output_buffer o;
+  return o;
+}
+
+template<typename T>
+struct is_sequence : std::false_type {};
+
+template<typename T, typename A>
+struct is_sequence<std::vector<T, A>> : std::true_type {};
+
+#ifdef __cpp_lib_span
+template<typename T, std::size_t N>
+struct is_sequence<std::span<T, N>> : std::true_type {};
+#endif
+
+template<typename T>
+struct is_optional_result : std::false_type {};
+
+template<typename T>
+struct is_optional_result<std::optional<T>> : std::true_type {};
+
+template<typename T>
+constexpr bool is_string_result {
+  std::is_convertible_v<T const &, std::string_view> };
+
+template<typename T>
+void print(std::ostream &os, T const &value)
+{
+  os << value;
+}
+
+template<typename T>
+void print(std::ostream &os, std::optional<T> const &value)
+{
+  if (value)
+    print(os, *value);
+}
+
+inline void write_json_string(std::string &buffer, std::string_view s)
+{
+  static constexpr char hex[] { "0123456789abcdef" };
+
+  buffer += '"';
+
+  for (char c : s) {
+    switch (c) {
+    case '"':
+      buffer += "\\\"";
+      break;
+    case '\\':
+      buffer += "\\\\";
+      break;
+    case '\n':
+      buffer += "\\n";
+      break;
+    case '\r':
+      buffer += "\\r";
+      break;
+    case '\t':
+      buffer += "\\t";
+      break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        buffer += "\\u00";
+        buffer += hex[(c >> 4) & 0xf];
+        buffer += hex[c & 0xf];
+      } else {
+        buffer += c;
+      }
+    }
+  }
+
+  buffer += '"';
+}
+
+template<typename T>
+void write_json_number(std::string &buffer, T value)
+{
+  if constexpr (std::is_floating_point_v<T>) {
+    // JSON has no representation for infinities and NaNs.
+    if (value != value || value - value != 0) {
+      buffer += "null";
+      return;
+    }
+  }
+
+  char number[64];
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+  constexpr bool use_to_chars { true };
+#else
+  constexpr bool use_to_chars { std::is_integral_v<T> };
+#endif
+
+  if constexpr (use_to_chars) {
+    auto [ptr, ec] = std::to_chars(number, number + sizeof(number), value);
+    buffer.append(number, ptr);
+  } else {
+    auto n { std::snprintf(number, sizeof(number), "%.17Lg",
+                           static_cast<long double>(value)) };
+    buffer.append(number, n);
+  }
+}
+
+template<typename T>
+void write_json(std::string &buffer, T const &value)
+{
+  if constexpr (std::is_same_v<T, bool>) {
+    buffer += value ? "true" : "false";
+
+  } else if constexpr (std::is_arithmetic_v<T>) {
+    write_json_number(buffer, value);
+
+  } else if constexpr (is_string_result<T>) {
+    write_json_string(buffer, std::string_view(value));
+
+  } else if constexpr (is_optional_result<T>::value) {
+    if (value)
+      write_json(buffer, *value);
+    else
+      buffer += "null";
+
+  } else if constexpr (is_sequence<T>::value) {
+    buffer += '[';
+
+    bool first { true };
+    for (auto const &element : value) {
+      if (!first)
+        buffer += ',';
+
+      write_json(buffer, element);
+      first = false;
+    }
+
+    buffer += ']';
+
+  } else {
+    // Anything else is serialized as the string operator<< produces.
+    std::ostringstream os;
+    print(os, value);
+
+    write_json_string(buffer, os.str());
+  }
+}
+
+template<typename T>
+void write_binary_raw(std::string &buffer, T value)
+{
+  char bytes[sizeof(T)];
+  std::memcpy(bytes, &value, sizeof(T));
+
+  buffer.append(bytes, sizeof(T));
+}
+
+// Arithmetic values are written as is, strings and sequences as a 64 bit
+// length followed by their characters/elements and optionals as a byte
+// indicating presence followed by the value if present.
+template<typename T>
+void write_binary(std::string &buffer, T const &value)
+{
+  if constexpr (std::is_same_v<T, bool>) {
+    buffer += static_cast<char>(value);
+
+  } else if constexpr (std::is_arithmetic_v<T>) {
+    write_binary_raw(buffer, value);
+
+  } else if constexpr (is_string_result<T>) {
+    std::string_view s { value };
+
+    write_binary_raw(buffer, static_cast<std::uint64_t>(s.size()));
+    buffer.append(s);
+
+  } else if constexpr (is_optional_result<T>::value) {
+    buffer += static_cast<char>(value.has_value());
+
+    if (value)
+      write_binary(buffer, *value);
+
+  } else if constexpr (is_sequence<T>::value) {
+    write_binary_raw(buffer, static_cast<std::uint64_t>(std::size(value)));
+
+    for (auto const &element : value)
+      write_binary(buffer, element);
+
+  } else {
+    std::ostringstream os;
+    print(os, value);
+
+    write_binary(buffer, os.str());
+  }
+}
+
+template<typename T>
+void write_result(T const &value)
+{
+  auto &out { output() };
+
+  switch (out.format()) {
+  case output_format::text:
+    print(std::cout, value);
+    std::cout << "\n";
+    return;
+  case output_format::jsonl:
+    write_json(out.buffer(), value);
+    out.buffer() += '\n';
+    break;
+  case output_format::binary:
+    write_binary(out.buffer(), value);
+    break;
+  }
+
+  out.flush_if_full();
+}
+
+namespace detail {
+
+template<typename F>
+void call_and_write(F &&f)
+{
+  using result_type = std::decay_t<std::invoke_result_t<F>>;
+
+  if constexpr (is_async<result_type>::value) {
+    auto &&result { std::forward<F>(f)() };
+
+    call_and_write([&result]() -> decltype(auto)
+                   { return await_result(std::forward<decltype(result)>(result)); });
+
+  } else if constexpr (std::is_void_v<std::invoke_result_t<F>>) {
+    std::forward<F>(f)();
+
+    profile().mark(phase::call);
+
+    auto &out { output() };
+
+    if (out.format() == output_format::jsonl) {
+      out.buffer() += "null\n";
+      out.flush_if_full();
+    }
+
+  } else {
+    auto &&result { std::forward<F>(f)() };
+
+    profile().mark(phase::call);
+
+    write_result(result);
+  }
+}
+
+} // end namespace detail
+
+// Invokes a launchpad's call and writes its result, if any. Futures and
+// tasks are waited for and their result is written instead.
+template<typename F>
+void print_result(F &&f)
+{
+  profile().mark(phase::bind);
+
+  detail::call_and_write(std::forward<F>(f));
+}
+
+} // end namespace fire::runtime
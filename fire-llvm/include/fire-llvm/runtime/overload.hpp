@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include <fire-llvm/runtime/args.hpp>
+
+namespace fire::runtime {
+
+// Selects one of the overloads of the current command given a decision table
+// generated by the plugin, see args::option_mask for how it is indexed.
+// Entries are overload indices, -1 if no overload accepts the arguments and
+// -2 if the arguments do not determine an overload.
+template<std::size_t num_options, std::size_t num_entries>
+std::size_t select_overload(args const &a,
+                            std::array<param, num_options> const &options,
+                            std::array<std::int8_t, num_entries> const &overloads)
+{
+  static_assert(num_entries == std::size_t(1) << (num_options + 1));
+
+  auto overload { overloads[a.option_mask(options)] };
+
+  if (overload == -1) {
+    throw error("no overload of '" + std::string(a.command()) +
+                "' accepts the given arguments");
+  }
+
+  if (overload == -2)
+    throw error("call of overloaded '" + std::string(a.command()) + "' is ambiguous");
+
+  return static_cast<std::size_t>(overload);
+}
+
+// Prints the usage messages of all overloads of the current command.
+template<typename... Launchpads>
+int print_overloads(args &a, Launchpads... launchpads)
+{
+  bool first { true };
+
+  ((first ? void(first = false) : void(std::cout << "\n"), launchpads(a)), ...);
+
+  return 0;
+}
+
+} // end namespace fire::runtime
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define FIRE_LLVM_RUSAGE
+#include <sys/resource.h>
+#endif
+
+namespace fire::runtime {
+
+// Phases of an invocation, each one ends where the next one begins.
+enum class phase
+{
+  startup,  // static initialization until 'main' is entered
+  parse,    // runtime options and tokenizing the command line
+  dispatch, // resolving (sub)commands
+  bind,     // binding and converting arguments
+  call,     // the fired function itself
+  output,   // writing the result
+  count
+};
+
+inline constexpr std::array<std::string_view, static_cast<std::size_t>(phase::count)>
+phase_names { "startup", "parse", "dispatch", "bind", "call", "output" };
+
+namespace detail {
+
+// Initialized together with the program's other globals, approximates the
+// start of static initialization.
+inline std::chrono::steady_clock::time_point const init_time {
+  std::chrono::steady_clock::now() };
+
+} // end namespace detail
+
+// Attributes wall time to phases, enabled by --fire-profile. When disabled,
+// every mark costs a single branch. Durations accumulate over all command
+// lines in batch and server mode.
+class profiler
+{
+public:
+  using clock = std::chrono::steady_clock;
+
+  bool enabled() const
+  { return enabled_; }
+
+  // Enables profiling, start is the time 'main' was entered. Writes a JSON
+  // object to the given file instead of a summary to stderr, if not empty.
+  void enable(clock::time_point start, std::string_view path = {})
+  {
+    enabled_ = true;
+    path_ = path;
+
+    times_[index(phase::startup)] += start - detail::init_time;
+    last_ = start;
+  }
+
+  // Ends phase p.
+  void mark(phase p)
+  {
+    if (!enabled_)
+      return;
+
+    auto now { clock::now() };
+
+    times_[index(p)] += now - last_;
+    last_ = now;
+  }
+
+  void report(std::ostream &err) const
+  {
+    if (!enabled_)
+      return;
+
+    if (path_.empty()) {
+      write_text(err);
+      return;
+    }
+
+    std::ofstream os(path_);
+    if (os)
+      write_json(os);
+
+    if (!os)
+      err << "error: failed to write profile to '" << path_ << "'\n";
+  }
+
+private:
+  struct usage
+  {
+    long max_rss_kb = 0;
+    long minor_faults = 0;
+    long major_faults = 0;
+    long voluntary_context_switches = 0;
+    long involuntary_context_switches = 0;
+  };
+
+  static constexpr std::size_t index(phase p)
+  { return static_cast<std::size_t>(p); }
+
+  static usage resource_usage()
+  {
+    usage u;
+
+#ifdef FIRE_LLVM_RUSAGE
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0) {
+#ifdef __APPLE__
+      u.max_rss_kb = ru.ru_maxrss / 1024;
+#else
+      u.max_rss_kb = ru.ru_maxrss;
+#endif
+      u.minor_faults = ru.ru_minflt;
+      u.major_faults = ru.ru_majflt;
+      u.voluntary_context_switches = ru.ru_nvcsw;
+      u.involuntary_context_switches = ru.ru_nivcsw;
+    }
+#endif
+
+    return u;
+  }
+
+  void write_text(std::ostream &os) const
+  {
+    auto u { resource_usage() };
+
+    os << "fire-llvm profile:\n";
+
+    for (std::size_t i { 0 }; i < phase_names.size(); ++i) {
+      std::chrono::duration<double, std::milli> ms { times_[i] };
+
+      os << "  " << std::left << std::setw(18) << phase_names[i]
+         << std::right << std::fixed << std::setprecision(3)
+         << std::setw(10) << ms.count() << " ms\n";
+    }
+
+    os << "  " << std::left << std::setw(18) << "max rss" << std::right
+       << std::setw(10) << u.max_rss_kb << " KiB\n"
+       << "  " << std::left << std::setw(18) << "page faults" << std::right
+       << std::setw(10) << u.minor_faults << " minor, "
+       << u.major_faults << " major\n"
+       << "  " << std::left << std::setw(18) << "context switches" << std::right
+       << std::setw(10) << u.voluntary_context_switches << " voluntary, "
+       << u.involuntary_context_switches << " involuntary\n";
+  }
+
+  void write_json(std::ostream &os) const
+  {
+    auto u { resource_usage() };
+
+    os << "{";
+
+    for (std::size_t i { 0 }; i < phase_names.size(); ++i) {
+      std::chrono::nanoseconds ns { times_[i] };
+
+      os << "\"" << phase_names[i] << "_ns\": " << ns.count() << ", ";
+    }
+
+    os << "\"max_rss_kb\": " << u.max_rss_kb << ", "
+       << "\"minor_faults\": " << u.minor_faults << ", "
+       << "\"major_faults\": " << u.major_faults << ", "
+       << "\"voluntary_context_switches\": " << u.voluntary_context_switches << ", "
+       << "\"involuntary_context_switches\": " << u.involuntary_context_switches
+       << "}\n";
+  }
+
+  bool enabled_ = false;
+  std::string path_;
+  clock::time_point last_;
+  std::array<clock::duration, phase_names.size()> times_ {};
+};
+
+inline profiler &profile()
+{
+  static profiler p;
+  return p;
+}
+
+} // end namespace fire::runtime
@@ -0,0 +1,362 @@
+#pragma once
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <fire-llvm/runtime/args.hpp>
+#include <fire-llvm/runtime/output.hpp>
+#include <fire-llvm/runtime/profile.hpp>
+
+namespace fire::runtime {
+
+// Requests and responses are exchanged over a Unix domain socket as frames of
+// length prefixed strings (lengths are 32 bit unsigned integers in host byte
+// order): a request consists of the number of arguments followed by the
+// arguments, a response of the exit status followed by everything the command
+// wrote to stdout and stderr. Any number of requests can be sent over one
+// connection.
+
+// Limits on requests, larger requests are protocol errors which end the
+// connection.
+inline constexpr std::uint32_t max_request_tokens { 1u << 20 };
+inline constexpr std::size_t max_request_size { std::size_t(1) << 28 };
+
+// Time a client may take to send a request before its connection is dropped,
+// clients are served one at a time.
+inline constexpr int client_timeout_seconds { 10 };
+
+struct response
+{
+  std::uint32_t status = 0;
+  std::string out;
+  std::string err;
+};
+
+inline bool write_all(int fd, void const *data, std::size_t size) noexcept
+{
+  auto bytes { static_cast<char const *>(data) };
+
+  while (size > 0) {
+    auto n { ::write(fd, bytes, size) };
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+
+      return false;
+    }
+
+    bytes += n;
+    size -= static_cast<std::size_t>(n);
+  }
+
+  return true;
+}
+
+inline bool read_all(int fd, void *data, std::size_t size) noexcept
+{
+  auto bytes { static_cast<char *>(data) };
+
+  while (size > 0) {
+    auto n { ::read(fd, bytes, size) };
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+
+      return false;
+    }
+
+    if (n == 0)
+      return false;
+
+    bytes += n;
+    size -= static_cast<std::size_t>(n);
+  }
+
+  return true;
+}
+
+inline bool write_u32(int fd, std::uint32_t value) noexcept
+{ return write_all(fd, &value, sizeof(value)); }
+
+inline bool read_u32(int fd, std::uint32_t &value) noexcept
+{ return read_all(fd, &value, sizeof(value)); }
+
+inline bool write_string(int fd, std::string_view s) noexcept
+{
+  return write_u32(fd, static_cast<std::uint32_t>(s.size())) &&
+         write_all(fd, s.data(), s.size());
+}
+
+inline bool read_string(int fd, std::string &s)
+{
+  std::uint32_t size;
+  if (!read_u32(fd, size))
+    return false;
+
+  s.resize(size);
+
+  return read_all(fd, s.data(), size);
+}
+
+template<typename IT>
+bool write_request(int fd, IT first, IT last)
+{
+  if (!write_u32(fd, static_cast<std::uint32_t>(last - first)))
+    return false;
+
+  for (; first != last; ++first) {
+    if (!write_string(fd, *first))
+      return false;
+  }
+
+  return true;
+}
+
+// Reads all arguments of a request into a single buffer, tokens point into it.
+// Returns false if the connection was closed or the request exceeds the
+// limits above.
+inline bool read_request(int fd,
+                         std::string &buffer,
+                         std::vector<std::string_view> &tokens)
+{
+  std::uint32_t num_tokens;
+  if (!read_u32(fd, num_tokens) || num_tokens > max_request_tokens)
+    return false;
+
+  buffer.clear();
+
+  std::vector<std::uint32_t> sizes(num_tokens);
+
+  for (auto &size : sizes) {
+    if (!read_u32(fd, size) || size > max_request_size - buffer.size())
+      return false;
+
+    auto offset { buffer.size() };
+    buffer.resize(offset + size);
+
+    if (!read_all(fd, buffer.data() + offset, size))
+      return false;
+  }
+
+  std::size_t offset { 0 };
+  for (auto size : sizes) {
+    tokens.emplace_back(buffer.data() + offset, size);
+    offset += size;
+  }
+
+  return true;
+}
+
+inline bool write_response(int fd, response const &r) noexcept
+{
+  return write_u32(fd, r.status) &&
+         write_string(fd, r.out) &&
+         write_string(fd, r.err);
+}
+
+inline bool read_response(int fd, response &r)
+{
+  return read_u32(fd, r.status) &&
+         read_string(fd, r.out) &&
+         read_string(fd, r.err);
+}
+
+inline sockaddr_un socket_address(std::string_view path)
+{
+  sockaddr_un address {};
+  address.sun_family = AF_UNIX;
+
+  if (path.size() >= sizeof(address.sun_path))
+    throw error("socket path '" + std::string(path) + "' is too long");
+
+  std::memcpy(address.sun_path, path.data(), path.size());
+
+  return address;
+}
+
+[[noreturn]] inline void socket_error(std::string const &what,
+                                      std::string_view path)
+{
+  throw error(what + " '" + std::string(path) + "': " + std::strerror(errno));
+}
+
+inline int listen_socket(std::string_view path)
+{
+  auto address { socket_address(path) };
+
+  // Remove stale sockets of earlier servers, but never anything else.
+  struct stat status;
+  if (::lstat(address.sun_path, &status) == 0) {
+    if (!S_ISSOCK(status.st_mode))
+      throw error("failed to listen on socket '" + std::string(path) + "': path exists");
+
+    ::unlink(address.sun_path);
+  }
+
+  int fd { ::socket(AF_UNIX, SOCK_STREAM, 0) };
+  if (fd < 0)
+    socket_error("failed to create socket", path);
+
+  if (::bind(fd, reinterpret_cast<sockaddr const *>(&address), sizeof(address)) < 0 ||
+      ::listen(fd, SOMAXCONN) < 0) {
+    ::close(fd);
+    socket_error("failed to listen on socket", path);
+  }
+
+  return fd;
+}
+
+inline int connect_socket(std::string_view path)
+{
+  auto address { socket_address(path) };
+
+  int fd { ::socket(AF_UNIX, SOCK_STREAM, 0) };
+  if (fd < 0)
+    socket_error("failed to create socket", path);
+
+  if (::connect(fd, reinterpret_cast<sockaddr const *>(&address), sizeof(address)) < 0) {
+    ::close(fd);
+    socket_error("failed to connect to socket", path);
+  }
+
+  return fd;
+}
+
+// Redirects std::cout and std::cerr for as long as it exists.
+class capture
+{
+public:
+  capture(std::ostream &out, std::ostream &err)
+  : out_(std::cout.rdbuf(out.rdbuf())),
+    err_(std::cerr.rdbuf(err.rdbuf()))
+  { output().redirect(&out); }
+
+  capture(capture const &) = delete;
+  capture &operator=(capture const &) = delete;
+
+  ~capture()
+  {
+    output().redirect(nullptr);
+
+    std::cout.rdbuf(out_);
+    std::cerr.rdbuf(err_);
+  }
+
+private:
+  std::streambuf *out_;
+  std::streambuf *err_;
+};
+
+// Serves requests on a Unix domain socket, one at a time, until killed.
+// Requests are dispatched through entry exactly like command lines. Only
+// output written through std::cout and std::cerr is sent back to clients.
+template<typename F>
+int run_server(std::string_view program, F &&entry, std::string_view path)
+{
+  std::signal(SIGPIPE, SIG_IGN);
+
+  int server { listen_socket(path) };
+
+  std::string buffer;
+  std::vector<std::string_view> tokens;
+
+  for (;;) {
+    int client { ::accept(server, nullptr, nullptr) };
+    if (client < 0) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+
+      socket_error("failed to accept connection on socket", path);
+    }
+
+    // A client that stops sending would block all others.
+    timeval timeout { client_timeout_seconds, 0 };
+    ::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    for (;;) {
+      tokens.clear();
+      tokens.push_back(program);
+
+      // Malformed requests only end the connection, not the server.
+      bool request;
+      try {
+        request = read_request(client, buffer, tokens);
+      } catch (std::exception const &) {
+        request = false;
+      }
+
+      if (!request)
+        break;
+
+      std::ostringstream out, err;
+
+      response r;
+
+      {
+        capture c(out, err);
+
+        try {
+          args a(tokens);
+
+          r.status = static_cast<std::uint32_t>(entry(a));
+
+        } catch (std::exception const &e) {
+          std::cerr << program << ": error: " << e.what() << "\n";
+          r.status = 1;
+        }
+      }
+
+      r.out = std::move(out).str();
+      r.err = std::move(err).str();
+
+      if (!write_response(client, r))
+        break;
+
+      profile().mark(phase::output);
+    }
+
+    ::close(client);
+  }
+}
+
+// Sends a single request to a server started with --fire-serve and forwards
+// its response.
+inline int run_client(std::string_view path, int argc, char const *const *argv)
+{
+  std::signal(SIGPIPE, SIG_IGN);
+
+  int fd { connect_socket(path) };
+
+  response r;
+
+  bool ok { write_request(fd, argv, argv + argc) && read_response(fd, r) };
+
+  ::close(fd);
+
+  if (!ok)
+    socket_error("lost connection to server on socket", path);
+
+  std::cout << r.out << std::flush;
+  std::cerr << r.err << std::flush;
+
+  return static_cast<int>(r.status);
+}
+
+} // end namespace fire::runtime
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fire-llvm/runtime/args.hpp>
+#include <fire-llvm/runtime/convert.hpp>
+
+namespace fire {
+
+// Input range of whitespace separated values read lazily, chunk by chunk,
+// from stdin or a file. A stream<T> parameter --name is bound to the file
+// given as --name=<file> and to stdin if the option is omitted or '-'. Like
+// any input range, a stream can only be traversed once.
+template<typename T>
+class stream
+{
+  static_assert(!std::is_same_v<T, std::string_view>,
+                "stream elements can not refer to the stream's buffer");
+
+public:
+  class iterator
+  {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T const *;
+    using reference = T const &;
+
+    iterator() = default;
+
+    explicit iterator(stream *s)
+    : s_(s)
+    { ++*this; }
+
+    reference operator*() const
+    { return value_; }
+
+    pointer operator->() const
+    { return &value_; }
+
+    iterator &operator++()
+    {
+      if (!s_->next(value_))
+        s_ = nullptr;
+
+      return *this;
+    }
+
+    void operator++(int)
+    { ++*this; }
+
+    friend bool operator==(iterator const &lhs, iterator const &rhs)
+    { return lhs.s_ == rhs.s_; }
+
+    friend bool operator!=(iterator const &lhs, iterator const &rhs)
+    { return lhs.s_ != rhs.s_; }
+
+  private:
+    stream *s_ = nullptr;
+    T value_ {};
+  };
+
+  static constexpr std::size_t chunk_size = 1 << 16;
+
+  stream(std::FILE *file, bool owned, runtime::param const &p)
+  : file_(file),
+    owned_(owned),
+    param_(p),
+    buffer_(chunk_size)
+  {}
+
+  stream(stream &&other) noexcept
+  : file_(std::exchange(other.file_, nullptr)),
+    owned_(other.owned_),
+    param_(other.param_),
+    buffer_(std::move(other.buffer_)),
+    begin_(other.begin_),
+    end_(other.end_),
+    eof_(other.eof_)
+  {}
+
+  stream &operator=(stream &&) = delete;
+
+  ~stream()
+  {
+    if (file_ && owned_)
+      std::fclose(file_);
+  }
+
+  static stream open(runtime::param const &p, runtime::slot const &s)
+  {
+    if (!s.present || s.value == "-")
+      return stream(stdin, false, p);
+
+    std::string path { s.value };
+
+    auto file { std::fopen(path.c_str(), "rb") };
+    if (!file)
+      throw runtime::error("failed to open '" + path + "': " + std::strerror(errno));
+
+    return stream(file, true, p);
+  }
+
+  iterator begin()
+  { return iterator(this); }
+
+  iterator end()
+  { return iterator(); }
+
+private:
+  bool next(T &value)
+  {
+    for (;;) {
+      while (begin_ != end_ && runtime::is_delimiter(buffer_[begin_]))
+        ++begin_;
+
+      auto token_end { begin_ };
+      while (token_end != end_ && !runtime::is_delimiter(buffer_[token_end]))
+        ++token_end;
+
+      // A token touching the end of the buffer might continue in the next
+      // chunk.
+      if (begin_ != end_ && (token_end != end_ || eof_)) {
+        value = runtime::parse<T>(
+          param_, std::string_view(buffer_.data() + begin_, token_end - begin_));
+
+        begin_ = token_end;
+
+        return true;
+      }
+
+      if (eof_)
+        return false;
+
+      fill();
+    }
+  }
+
+  void fill()
+  {
+    // Keep the beginning of a partially read token.
+    std::memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+    end_ -= begin_;
+    begin_ = 0;
+
+    if (end_ == buffer_.size())
+      buffer_.resize(2 * buffer_.size());
+
+    auto n { std::fread(buffer_.data() + end_, 1, buffer_.size() - end_, file_) };
+
+    if (n == 0) {
+      if (std::ferror(file_))
+        throw runtime::error("failed to read input of '" + std::string(param_.name) + "'");
+
+      eof_ = true;
+    }
+
+    end_ += n;
+  }
+
+  std::FILE *file_;
+  bool owned_;
+  runtime::param param_;
+  std::vector<char> buffer_;
+  std::size_t begin_ = 0;
+  std::size_t end_ = 0;
+  bool eof_ = false;
+};
+
+} // end namespace fire
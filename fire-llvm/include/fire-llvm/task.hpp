@@ -0,0 +1,208 @@
+#pragma once
+
+#if __has_include(<coroutine>) && defined(__cpp_impl_coroutine)
+
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+#include <fire-llvm/runtime/async.hpp>
+
+#define FIRE_LLVM_TASK
+
+namespace fire {
+
+namespace detail {
+
+template<typename T>
+struct task_result
+{
+  template<typename U>
+  void return_value(U &&value)
+  { value_.emplace(std::forward<U>(value)); }
+
+  T get()
+  { return std::move(*value_); }
+
+  std::optional<T> value_;
+};
+
+template<>
+struct task_result<void>
+{
+  void return_void() noexcept
+  {}
+
+  void get() noexcept
+  {}
+};
+
+// Completion state of a task run by task::sync_wait.
+struct task_signal
+{
+  void notify()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    done = true;
+    cv.notify_one();
+  }
+
+  void wait()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this]() { return done; });
+  }
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool done = false;
+};
+
+} // end namespace detail
+
+// Lazily started coroutine producing a T. Fired methods may return tasks,
+// these are run to completion before their result is printed. Within a task,
+// co_await schedule() continues on the built-in executor and co_await on
+// another task runs it and resumes once it has completed.
+template<typename T = void>
+class task
+{
+public:
+  using value_type = T;
+
+  struct promise_type : detail::task_result<T>
+  {
+    task get_return_object()
+    { return task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+
+    std::suspend_always initial_suspend() noexcept
+    { return {}; }
+
+    auto final_suspend() noexcept
+    {
+      struct final_awaiter
+      {
+        bool await_ready() noexcept
+        { return false; }
+
+        std::coroutine_handle<>
+        await_suspend(std::coroutine_handle<promise_type> h) noexcept
+        {
+          auto &promise { h.promise() };
+
+          if (promise.continuation_)
+            return promise.continuation_;
+
+          if (promise.signal_)
+            promise.signal_->notify();
+
+          return std::noop_coroutine();
+        }
+
+        void await_resume() noexcept
+        {}
+      };
+
+      return final_awaiter {};
+    }
+
+    void unhandled_exception() noexcept
+    { exception_ = std::current_exception(); }
+
+    T result()
+    {
+      if (exception_)
+        std::rethrow_exception(exception_);
+
+      return this->get();
+    }
+
+    std::coroutine_handle<> continuation_;
+    detail::task_signal *signal_ = nullptr;
+    std::exception_ptr exception_;
+  };
+
+  task(task &&other) noexcept
+  : handle_(std::exchange(other.handle_, nullptr))
+  {}
+
+  task &operator=(task other) noexcept
+  {
+    std::swap(handle_, other.handle_);
+    return *this;
+  }
+
+  ~task()
+  {
+    if (handle_)
+      handle_.destroy();
+  }
+
+  auto operator co_await() && noexcept
+  {
+    struct awaiter
+    {
+      bool await_ready() noexcept
+      { return false; }
+
+      std::coroutine_handle<>
+      await_suspend(std::coroutine_handle<> continuation) noexcept
+      {
+        handle_.promise().continuation_ = continuation;
+        return handle_;
+      }
+
+      T await_resume()
+      { return handle_.promise().result(); }
+
+      std::coroutine_handle<promise_type> handle_;
+    };
+
+    return awaiter { handle_ };
+  }
+
+  // Runs t and blocks until it has completed.
+  static T sync_wait(task t)
+  {
+    detail::task_signal signal;
+
+    t.handle_.promise().signal_ = &signal;
+    t.handle_.resume();
+
+    signal.wait();
+
+    return t.handle_.promise().result();
+  }
+
+private:
+  explicit task(std::coroutine_handle<promise_type> handle) noexcept
+  : handle_(handle)
+  {}
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+// Continues the awaiting coroutine on the built-in executor.
+inline auto schedule() noexcept
+{
+  struct awaiter
+  {
+    bool await_ready() noexcept
+    { return false; }
+
+    void await_suspend(std::coroutine_handle<> h)
+    { runtime::default_executor().post([h]() { h.resume(); }); }
+
+    void await_resume() noexcept
+    {}
+  };
+
+  return awaiter {};
+}
+
+} // end namespace fire
+
+#endif // __has_include(<coroutine>) && defined(__cpp_impl_coroutine)
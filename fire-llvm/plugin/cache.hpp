@@ -0,0 +1,169 @@
+#pragma once
+
+#include <dlfcn.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Basic/Version.h"
+#include "clang/Frontend/CompilerInstance.h"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Chrono.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "file.hpp"
+
+namespace cache {
+
+inline std::string digest(llvm::MD5 &Hash)
+{
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+
+  return Result.digest().str().str();
+}
+
+// Objects produced by different builds of the plugin must never be mixed up,
+// so the plugin binary itself is part of every key.
+inline std::string pluginIdentity()
+{
+  Dl_info Info;
+  if (!dladdr(reinterpret_cast<void *>(&pluginIdentity), &Info) ||
+      !Info.dli_fname)
+    return "";
+
+  llvm::sys::fs::file_status Status;
+  if (llvm::sys::fs::status(Info.dli_fname, Status))
+    return Info.dli_fname;
+
+  return llvm::formatv("{0} {1} {2}",
+                       Info.dli_fname,
+                       Status.getSize(),
+                       llvm::sys::toTimeT(Status.getLastModificationTime()));
+}
+
+// Adds the compiler command line of CI to Hash, except for the output file,
+// which does not affect the generated code.
+inline void commandLine(clang::CompilerInstance &CI, llvm::MD5 &Hash)
+{
+  bool OutputFile { false };
+
+  for (auto Arg : CI.getCodeGenOpts().CommandLineArgs) {
+    if (OutputFile) {
+      OutputFile = false;
+      continue;
+    }
+
+    if (llvm::StringRef(Arg) == "-o") {
+      OutputFile = true;
+      continue;
+    }
+
+    Hash.update(Arg);
+    Hash.update(llvm::StringRef("\0", 1));
+  }
+}
+
+// Key of the object file generated for the translation unit currently being
+// compiled by CI. It covers the paths and contents of all input files, the
+// compiler command line except for the output file and the fire glue injected
+// into (or the rewritten contents of) the main file. Paths of input files end
+// up in the object (and its debug info), entries are thus only shared by
+// compilations of the same source files, but regardless of where they write
+// their objects.
+inline std::string key(clang::CompilerInstance &CI, llvm::StringRef Glue)
+{
+  auto &SourceManager { CI.getSourceManager() };
+
+  std::vector<std::pair<std::string, std::string>> Files;
+
+  for (auto It { SourceManager.fileinfo_begin() };
+       It != SourceManager.fileinfo_end();
+       ++It) {
+    auto File { It->first };
+
+    llvm::MD5 FileHash;
+
+    bool Invalid { true };
+
+    auto FileID { SourceManager.translateFile(File) };
+    if (FileID.isValid()) {
+      auto FileContent { SourceManager.getBufferData(FileID, &Invalid) };
+      if (!Invalid)
+        FileHash.update(FileContent);
+    }
+
+    if (Invalid) {
+      FileHash.update(llvm::formatv("{0} {1}",
+                                    File->getSize(),
+                                    File->getModificationTime()).str());
+    }
+
+    Files.emplace_back(File->getName().str(), digest(FileHash));
+  }
+
+  // File infos are keyed on pointers, their order differs between runs.
+  std::sort(Files.begin(), Files.end());
+
+  llvm::MD5 Hash;
+
+  Hash.update(clang::getClangFullVersion());
+  Hash.update(pluginIdentity());
+
+  commandLine(CI, Hash);
+
+  for (auto const &[FileName, FileDigest] : Files) {
+    Hash.update(FileName);
+    Hash.update(FileDigest);
+  }
+
+  Hash.update(Glue);
+
+  return digest(Hash);
+}
+
+inline std::string objectPath(std::string const &CacheDir,
+                              std::string const &Key)
+{
+  llvm::SmallString<128> ObjectPath { CacheDir };
+  llvm::sys::path::append(ObjectPath, "objects", Key + ".o");
+
+  return ObjectPath.str().str();
+}
+
+inline std::unique_ptr<llvm::MemoryBuffer> load(std::string const &CacheDir,
+                                                std::string const &Key)
+{
+  auto Object { llvm::MemoryBuffer::getFile(objectPath(CacheDir, Key)) };
+  if (!Object)
+    return nullptr;
+
+  return std::move(*Object);
+}
+
+inline bool store(std::string const &CacheDir,
+                  std::string const &Key,
+                  llvm::StringRef Object)
+{
+  auto ObjectPath { objectPath(CacheDir, Key) };
+
+  if (llvm::sys::fs::create_directories(llvm::sys::path::parent_path(ObjectPath)))
+    return false;
+
+  return file::writeAtomically(ObjectPath, Object);
+}
+
+} // end namespace cache
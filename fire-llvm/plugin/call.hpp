@@ -0,0 +1,96 @@
+#pragma once
+
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Decl.h"
+#include "clang/AST/Expr.h"
+#include "clang/AST/RecursiveASTVisitor.h"
+#include "clang/AST/Stmt.h"
+#include "clang/Basic/SourceManager.h"
+
+#include "llvm/Support/Casting.h"
+
+#include "namespace.hpp"
+
+namespace call {
+
+inline bool isFire(clang::CallExpr const *Call)
+{
+  auto Callee { Call->getDirectCallee() };
+  if (!Callee || !Callee->getPrimaryTemplate())
+    return false;
+
+  auto II { Callee->getIdentifier() };
+  if (!II || II->getName() != "fire_llvm")
+    return false;
+
+  return ns::isIn(Callee, "fire");
+}
+
+class FireCallFinder : public clang::RecursiveASTVisitor<FireCallFinder>
+{
+public:
+  bool VisitCallExpr(clang::CallExpr *Call)
+  {
+    if (!isFire(Call))
+      return true;
+
+    FireCall_ = Call;
+
+    // Stop traversal.
+    return false;
+  }
+
+  clang::CallExpr const *fireCall() const
+  { return FireCall_; }
+
+private:
+  clang::CallExpr const *FireCall_ = nullptr;
+};
+
+inline clang::CallExpr const *findFire(clang::Stmt *Body)
+{
+  FireCallFinder Finder;
+  Finder.TraverseStmt(Body);
+
+  return Finder.fireCall();
+}
+
+// Searches the body of a top-level function definition for a fire call.
+// Declarations outside of the main file (i.e. from headers) are skipped
+// without being traversed. If a call is found, D is a FunctionDecl.
+inline clang::CallExpr const *findFire(clang::SourceManager const &SourceManager,
+                                       clang::Decl *D)
+{
+  auto Function { llvm::dyn_cast<clang::FunctionDecl>(D) };
+  if (!Function || !Function->doesThisDeclarationHaveABody())
+    return nullptr;
+
+  if (!SourceManager.isInMainFile(Function->getLocation()))
+    return nullptr;
+
+  return findFire(Function->getBody());
+}
+
+// Searches all declarations in the main file, including namespaces, classes
+// and templates, for a fire call. This is slower than the search above and
+// only used to diagnose calls that it does not find.
+inline clang::CallExpr const *findFireInMainFile(clang::ASTContext &Context)
+{
+  auto &SourceManager { Context.getSourceManager() };
+
+  FireCallFinder Finder;
+
+  for (auto D : Context.getTranslationUnitDecl()->decls()) {
+    if (!SourceManager.isInMainFile(SourceManager.getExpansionLoc(D->getLocation())))
+      continue;
+
+    Finder.TraverseDecl(D);
+
+    if (Finder.fireCall())
+      break;
+  }
+
+  return Finder.fireCall();
+}
+
+} // end namespace call
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Decl.h"
+#include "clang/AST/RawCommentList.h"
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+
+namespace comment {
+
+// Documentation extracted from a doc comment: the first paragraph and the
+// descriptions following \param (or @param) commands. Other commands and
+// everything after them are ignored.
+struct Comment
+{
+  std::string Brief;
+  std::vector<std::pair<std::string, std::string>> Params;
+
+  std::string param(llvm::StringRef Name) const
+  {
+    for (auto const &[ParamName, ParamHelp] : Params) {
+      if (ParamName == Name)
+        return ParamHelp;
+    }
+
+    return "";
+  }
+};
+
+inline void append(std::string &Text, llvm::StringRef Line)
+{
+  if (!Text.empty())
+    Text += ' ';
+
+  Text += Line.str();
+}
+
+inline Comment parse(clang::ASTContext &Context, clang::Decl const *Decl)
+{
+  Comment C;
+
+  auto Raw { Context.getRawCommentForAnyRedecl(Decl) };
+  if (!Raw)
+    return C;
+
+  auto Text { Raw->getFormattedText(Context.getSourceManager(),
+                                    Context.getDiagnostics()) };
+
+  llvm::SmallVector<llvm::StringRef, 16> Lines;
+  llvm::StringRef(Text).split(Lines, '\n');
+
+  // Text is appended to the brief (0), a parameter (i + 1) or ignored (-1).
+  int Current { 0 };
+
+  for (auto Line : Lines) {
+    Line = Line.trim();
+
+    if (Line.empty()) {
+      if (Current == 0 && !C.Brief.empty())
+        Current = -1;
+
+      continue;
+    }
+
+    if (Line.consume_front("\\param") || Line.consume_front("@param")) {
+      Line = Line.ltrim();
+
+      // Skip direction, e.g. \param[in].
+      if (Line.startswith("["))
+        Line = Line.drop_until([](char c) { return c == ']'; }).drop_front();
+
+      auto [Name, Help] = Line.ltrim().split(' ');
+
+      C.Params.emplace_back(Name.str(), Help.trim().str());
+      Current = static_cast<int>(C.Params.size());
+
+    } else if (Line.startswith("\\") || Line.startswith("@")) {
+      Current = -1;
+
+    } else if (Current == 0) {
+      append(C.Brief, Line);
+
+    } else if (Current > 0) {
+      append(C.Params[Current - 1].second, Line);
+    }
+  }
+
+  return C;
+}
+
+} // end namespace comment
@@ -8,13 +8,19 @@
 #include "clang/Frontend/CompilerInvocation.h"
 #include "clang/Lex/PreprocessorOptions.h"
 
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "preamble.hpp"
 
 template<typename IT>
-inline void compile(clang::CompilerInstance *CI,
+inline bool compile(clang::CompilerInstance *CI,
                     std::string const &FileName,
                     IT FileBegin,
-                    IT FileEnd)
+                    IT FileEnd,
+                    std::string const &PreambleCacheDir = "",
+                    llvm::SmallVectorImpl<char> *Object = nullptr)
 {
   auto &CodeGenOpts { CI->getCodeGenOpts() };
   auto &Target { CI->getTarget() };
@@ -29,13 +35,27 @@ inline void compile(clang::CompilerInstance *CI,
 
   assert(CInvNewCreated);
 
+  // create rewrite buffer
+  std::string FileContent { FileBegin, FileEnd };
+
+  // skip over the (unchanged) preamble of the rewritten file
+  bool PreambleUsed {
+    preamble::use(CI, *CInvNew, FileName, FileContent, PreambleCacheDir) };
+
+  // the first pass already produced complete dependency output, headers read
+  // from the precompiled preamble would be missing from it here
+  if (PreambleUsed)
+    CInvNew->getDependencyOutputOpts() = clang::DependencyOutputOptions();
+
   clang::CompilerInstance CINew;
   CINew.setInvocation(CInvNew);
   CINew.setTarget(&Target);
   CINew.createDiagnostics();
 
-  // create rewrite buffer
-  std::string FileContent { FileBegin, FileEnd };
+  // write object file to memory instead of the output file
+  if (Object)
+    CINew.setOutputStream(std::make_unique<llvm::raw_svector_ostream>(*Object));
+
   auto FileMemoryBuffer { llvm::MemoryBuffer::getMemBufferCopy(FileContent) };
 
   // create "virtual" input file
@@ -44,8 +64,10 @@ inline void compile(clang::CompilerInstance *CI,
 
   // generate code
   clang::EmitObjAction EmitObj;
-  CINew.ExecuteAction(EmitObj);
+  bool Success { CINew.ExecuteAction(EmitObj) };
 
   // clean up rewrite buffer
   FileMemoryBuffer.release();
+
+  return Success && !CINew.getDiagnostics().hasErrorOccurred();
 }
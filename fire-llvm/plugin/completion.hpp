@@ -0,0 +1,207 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "file.hpp"
+
+// Shell completion for fired programs. The plugin writes an index of all
+// command paths and the words that can follow them, shell scripts look up the
+// current command line in it without ever running the program.
+namespace completion {
+
+class Index
+{
+public:
+  // Launchpad or entry point called by 'main'.
+  void root(std::string const &Name)
+  { Root_ = Name; }
+
+  // Adds a word that can follow the command path of the given launchpad or
+  // entry point. If Target is not empty, the word is a command dispatching to
+  // the launchpad or entry point of that name.
+  void add(std::string const &Name,
+           std::string const &Word,
+           std::string const &Target = "")
+  {
+    auto &Words { Words_[Name] };
+
+    auto It { std::find_if(Words.begin(), Words.end(),
+                           [&Word](auto const &W) { return W.first == Word; }) };
+
+    if (It == Words.end())
+      Words.emplace_back(Word, Target);
+  }
+
+  bool empty() const
+  { return Root_.empty(); }
+
+  // One line per command path: the space separated path, followed by the
+  // words that can follow it, all separated by tabs.
+  std::string str() const
+  {
+    std::string Str;
+    write(Root_, "", Str);
+
+    return Str;
+  }
+
+private:
+  void write(std::string const &Name,
+             std::string const &Path,
+             std::string &Str) const
+  {
+    static std::vector<std::pair<std::string, std::string>> const None;
+
+    auto It { Words_.find(Name) };
+    auto const &Words { It == Words_.end() ? None : It->second };
+
+    Str += Path;
+    for (auto const &[Word, Target] : Words)
+      Str += "\t" + Word;
+    Str += "\t-h\t--help\n";
+
+    for (auto const &[Word, Target] : Words) {
+      if (!Target.empty())
+        write(Target, Path.empty() ? Word : Path + " " + Word, Str);
+    }
+  }
+
+  std::string Root_;
+  std::map<std::string, std::vector<std::pair<std::string, std::string>>> Words_;
+};
+
+// Shell function names can not contain all characters program names can.
+inline std::string functionName(llvm::StringRef Program)
+{
+  std::string Name { "_fire_llvm_" };
+
+  for (auto C : Program)
+    Name += std::isalnum(static_cast<unsigned char>(C)) ? C : '_';
+
+  return Name;
+}
+
+// Options taking a value end in '=', no space is appended when completing
+// them.
+inline std::string bash(llvm::StringRef Program, llvm::StringRef IndexPath)
+{
+  return llvm::formatv(R"(# bash completion for {0}, generated by fire-llvm.
+{1}()
+{{
+  local -A commands
+  local line word cmd="" i
+
+  while IFS= read -r line; do
+    commands[":${{line%%$'\t'*}"]=${{line#*$'\t'}
+  done < '{2}'
+
+  for ((i = 1; i < COMP_CWORD; i++)); do
+    word=${{COMP_WORDS[i]}
+    if [[ -v commands[":${{cmd:+$cmd }$word"] ]]; then
+      cmd=${{cmd:+$cmd }$word
+    fi
+  done
+
+  [[ ${{COMP_WORDS[COMP_CWORD]} == = || ${{COMP_WORDS[COMP_CWORD-1]} == = ]] && return
+
+  local IFS=$'\t\n'
+  COMPREPLY=($(compgen -W "${{commands[":$cmd"]}" -- "${{COMP_WORDS[COMP_CWORD]}"))
+
+  [[ ${{#COMPREPLY[@]} -eq 1 && ${{COMPREPLY[0]} == *= ]] && compopt -o nospace
+}
+complete -F {1} {0}
+)", Program, functionName(Program), IndexPath).str();
+}
+
+inline std::string zsh(llvm::StringRef Program, llvm::StringRef IndexPath)
+{
+  return llvm::formatv(R"(#compdef {0}
+# zsh completion for {0}, generated by fire-llvm.
+{1}()
+{{
+  local -A commands
+  local line word cmd=""
+  local -a candidates
+
+  while IFS= read -r line; do
+    commands[:${{line%%$'\t'*}]=${{line#*$'\t'}
+  done < '{2}'
+
+  for word in ${{words[2,CURRENT-1]}; do
+    if (( ${{+commands[:${{cmd:+$cmd }$word]} )); then
+      cmd=${{cmd:+$cmd }$word
+    fi
+  done
+
+  candidates=(${{(ps:\t:)commands[:$cmd]})
+
+  compadd -S '' -- ${{(M)candidates:#*=}
+  compadd -- ${{candidates:#*=}
+}
+compdef {1} {0}
+)", Program, functionName(Program), IndexPath).str();
+}
+
+inline std::string fish(llvm::StringRef Program, llvm::StringRef IndexPath)
+{
+  return llvm::formatv(R"(# fish completion for {0}, generated by fire-llvm.
+function {1}
+    set -l lines
+    while read -l line
+        set -a lines $line
+    end < '{2}'
+
+    set -l tokens (commandline -opc)
+    set -e tokens[1]
+
+    set -l cmd ""
+    for token in $tokens
+        set -l next (string trim -- "$cmd $token")
+        if string match -q -- "$next"\t'*' $lines
+            set cmd $next
+        end
+    end
+
+    set -l line (string match -- "$cmd"\t'*' $lines)
+    set -l words (string split \t -- $line[1])
+    printf '%s\n' $words[2..-1]
+end
+complete -c {0} -f -a '({1})'
+)", Program, functionName(Program), IndexPath).str();
+}
+
+// Writes the index to <Prefix>.fire-completion and completion scripts for the
+// program named after the last component of Prefix to <Prefix>.bash,
+// <Prefix>.zsh and <Prefix>.fish.
+inline bool write(std::string const &Prefix, Index const &Idx)
+{
+  llvm::SmallString<128> IndexPath { Prefix + ".fire-completion" };
+  if (llvm::sys::fs::make_absolute(IndexPath))
+    return false;
+
+  auto Dir { llvm::sys::path::parent_path(IndexPath) };
+  if (!Dir.empty() && llvm::sys::fs::create_directories(Dir))
+    return false;
+
+  auto Program { llvm::sys::path::filename(Prefix) };
+
+  return file::writeAtomically(IndexPath.str().str(), Idx.str()) &&
+         file::writeAtomically(Prefix + ".bash", bash(Program, IndexPath)) &&
+         file::writeAtomically(Prefix + ".zsh", zsh(Program, IndexPath)) &&
+         file::writeAtomically(Prefix + ".fish", fish(Program, IndexPath));
+}
+
+} // end namespace completion
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "fire-llvm/runtime/dispatch.hpp"
+
+namespace dispatch {
+
+// Minimal perfect hash using the "hash and displace" scheme: keys are first
+// distributed into buckets, then every bucket is assigned a displacement
+// (used as the seed of a second hash) that maps all of its keys to free
+// slots. A lookup thus always costs two hashes and one string comparison,
+// see fire::runtime::lookup.
+struct PerfectHash
+{
+  std::vector<std::uint32_t> Displacements;
+  std::vector<std::string> Slots;
+};
+
+inline bool tryPerfectHash(std::vector<std::string> const &Keys,
+                           std::size_t NumSlots,
+                           PerfectHash &PH)
+{
+  constexpr std::uint32_t MaxDisplacement { 1u << 16 };
+
+  std::size_t NumBuckets { std::max<std::size_t>(1, (Keys.size() + 3) / 4) };
+
+  std::vector<std::vector<std::size_t>> Buckets(NumBuckets);
+  for (std::size_t i { 0 }; i < Keys.size(); ++i)
+    Buckets[fire::runtime::hash(Keys[i], 0) % NumBuckets].push_back(i);
+
+  // Place large buckets first while there are still many free slots.
+  std::vector<std::size_t> BucketOrder(NumBuckets);
+  std::iota(BucketOrder.begin(), BucketOrder.end(), 0);
+
+  std::stable_sort(BucketOrder.begin(), BucketOrder.end(),
+                   [&Buckets](std::size_t b1, std::size_t b2)
+                   { return Buckets[b1].size() > Buckets[b2].size(); });
+
+  PH.Displacements.assign(NumBuckets, 0);
+  PH.Slots.assign(NumSlots, "");
+
+  std::vector<bool> SlotTaken(NumSlots, false);
+  std::vector<std::size_t> BucketSlots;
+
+  for (auto b : BucketOrder) {
+    auto const &Bucket { Buckets[b] };
+    if (Bucket.empty())
+      break;
+
+    bool Placed { false };
+
+    for (std::uint32_t d { 1 }; d < MaxDisplacement && !Placed; ++d) {
+      BucketSlots.clear();
+
+      Placed = true;
+
+      for (auto k : Bucket) {
+        std::size_t Slot { fire::runtime::hash(Keys[k], d) % NumSlots };
+
+        if (SlotTaken[Slot] ||
+            std::find(BucketSlots.begin(), BucketSlots.end(), Slot) != BucketSlots.end()) {
+          Placed = false;
+          break;
+        }
+
+        BucketSlots.push_back(Slot);
+      }
+
+      if (Placed)
+        PH.Displacements[b] = d;
+    }
+
+    if (!Placed)
+      return false;
+
+    for (std::size_t i { 0 }; i < Bucket.size(); ++i) {
+      SlotTaken[BucketSlots[i]] = true;
+      PH.Slots[BucketSlots[i]] = Keys[Bucket[i]];
+    }
+  }
+
+  return true;
+}
+
+// Keys must be unique.
+inline PerfectHash perfectHash(std::vector<std::string> const &Keys)
+{
+  PerfectHash PH;
+
+  std::size_t NumSlots { std::max<std::size_t>(1, Keys.size()) };
+
+  while (!tryPerfectHash(Keys, NumSlots, PH))
+    NumSlots += NumSlots / 8 + 1;
+
+  return PH;
+}
+
+} // end namespace dispatch
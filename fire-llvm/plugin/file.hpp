@@ -0,0 +1,61 @@
+#pragma once
+
+#include <system_error>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+
+// Files written by the plugin can be read concurrently, by other compilations
+// sharing a cache or by shells completing a command line. They are written to
+// a temporary file next to their destination first and then renamed into
+// place, so that readers only ever see complete files.
+namespace file {
+
+// Picks a temporary path for a file that will replace Path.
+inline bool temporaryPath(llvm::StringRef Path, llvm::SmallVectorImpl<char> &TmpPath)
+{
+  return !llvm::sys::fs::getPotentiallyUniqueFileName(Path + "-%%%%%%%%", TmpPath);
+}
+
+// Renames TmpPath to Path, TmpPath is removed if that fails.
+inline bool replace(llvm::StringRef TmpPath, llvm::StringRef Path)
+{
+  if (llvm::sys::fs::rename(TmpPath, Path)) {
+    llvm::sys::fs::remove(TmpPath);
+    return false;
+  }
+
+  return true;
+}
+
+// Replaces the contents of Path with Content. Write errors are returned
+// instead of being fatal, Path is then left unchanged.
+inline bool writeAtomically(llvm::StringRef Path, llvm::StringRef Content)
+{
+  llvm::SmallString<128> TmpPath;
+  if (!temporaryPath(Path, TmpPath))
+    return false;
+
+  {
+    std::error_code EC;
+    llvm::raw_fd_ostream Stream(TmpPath, EC);
+    if (EC)
+      return false;
+
+    Stream << Content;
+    Stream.close();
+
+    if (Stream.has_error()) {
+      Stream.clear_error();
+      llvm::sys::fs::remove(TmpPath);
+      return false;
+    }
+  }
+
+  return replace(TmpPath, Path);
+}
+
+} // end namespace file
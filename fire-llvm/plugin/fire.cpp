@@ -1,15 +1,17 @@
+#include <algorithm>
+#include <bitset>
+#include <functional>
 #include <memory>
 #include <stdexcept>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/Decl.h"
 #include "clang/AST/DeclCXX.h"
-#include "clang/ASTMatchers/ASTMatchFinder.h"
-#include "clang/ASTMatchers/ASTMatchers.h"
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/DiagnosticIDs.h"
 #include "clang/Basic/SourceLocation.h"
@@ -18,18 +20,32 @@
 #include "clang/Frontend/CompilerInvocation.h"
 #include "clang/Frontend/FrontendAction.h"
 #include "clang/Frontend/FrontendPluginRegistry.h"
+#include "clang/Frontend/MultiplexConsumer.h"
+#include "clang/Lex/Pragma.h"
+#include "clang/Lex/Preprocessor.h"
+#include "clang/Lex/PreprocessorOptions.h"
 #include "clang/Rewrite/Core/Rewriter.h"
 
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
 
+#include "cache.hpp"
+#include "call.hpp"
+#include "comment.hpp"
 #include "compile.hpp"
-#include "node.hpp"
+#include "completion.hpp"
+#include "dispatch.hpp"
+#include "options.hpp"
 #include "print.hpp"
 #include "record.hpp"
-#include "string.hpp"
+#include "split.hpp"
+#include "stats.hpp"
 #include "type.hpp"
+#include "usermain.hpp"
 
 namespace {
 
@@ -57,22 +73,73 @@ private:
   clang::SourceLocation Where_;
 };
 
-class FireMatchCallback : public clang::ast_matchers::MatchFinder::MatchCallback
+// Glue that can not be compiled in a translation unit of its own.
+class FireSplitError : public FireError
 {
 public:
-  FireMatchCallback(clang::ASTContext &Context,
-                    clang::FileID *FileID,
-                    clang::Rewriter *FileRewriter)
+  using FireError::FireError;
+};
+
+void reportFireError(clang::DiagnosticsEngine &Diags,
+                     FireError const &e,
+                     clang::DiagnosticIDs::Level Level = clang::DiagnosticIDs::Error)
+{
+  unsigned ID { Diags.getDiagnosticIDs()->getCustomDiagID(Level, e.what()) };
+
+  Diags.Report(e.where(), ID);
+}
+
+void reportFireWarnings(clang::DiagnosticsEngine &Diags,
+                        std::vector<FireError> const &Warnings)
+{
+  for (auto const &e : Warnings)
+    reportFireError(Diags, e, clang::DiagnosticIDs::Warning);
+}
+
+// Fire calls are only searched for in top-level functions of the main file,
+// which is all that is needed for valid programs. If none was found there,
+// this looks for misplaced calls everywhere else in the main file and
+// reports them. Returns whether one was found.
+bool reportMisplacedFire(clang::ASTContext &Context)
+{
+  auto FireCall { call::findFireInMainFile(Context) };
+  if (!FireCall)
+    return false;
+
+  reportFireError(Context.getDiagnostics(),
+                  FireError("fire::fire_llvm must be called inside 'main'", FireCall));
+
+  return true;
+}
+
+class FireGlue
+{
+public:
+  // If Thunks is not null, the glue is generated for a separate translation
+  // unit: launchpads only depend on the runtime and call thunks which are
+  // appended to Thunks, to be compiled as part of the user's translation unit.
+  // If Completion is not null, all commands and options are added to it.
+  FireGlue(clang::ASTContext &Context,
+           stats::Stats *Stats = nullptr,
+           std::string *Thunks = nullptr,
+           completion::Index *Completion = nullptr)
   : Context_(Context),
-    FileID_(FileID),
-    FileRewriter_(FileRewriter)
+    Stats_(Stats),
+    Thunks_(Thunks),
+    Completion_(Completion)
   {}
 
-  void run(clang::ast_matchers::MatchFinder::MatchResult const &Result) override
+  // Problems that did not prevent generating the glue, to be reported once
+  // it is used.
+  std::vector<FireError> const &warnings() const
+  { return Warnings_; }
+
+  std::string fireMain(clang::CallExpr const *FireCall) const
   {
-    // Locate fire::fire_llm call
+    stats::Scope Scope(Stats_, stats::Glue);
 
-    auto FireCall { Result.Nodes.getNodeAs<clang::CallExpr>("fire") };
+    if (FireCall->getNumArgs() == 0)
+      return fireMainType(FireCall);
 
     if (FireCall->getNumArgs() != 1)
       throw FireError("fire::fire_llvm expects exactly one argument", FireCall);
@@ -81,24 +148,6 @@ public:
     if (!FireCallArg)
       throw FireError("fire::fire_llvm expects a function or class type argument", FireCall);
 
-    // Locate main function.
-
-    clang::FunctionDecl const *Main { nullptr };
-
-    for (auto const &FireCallAncestor : node::getAncestors(Context_, *FireCall)) {
-      auto MaybeMain { FireCallAncestor.get<clang::FunctionDecl>() };
-
-      if (MaybeMain && MaybeMain->isMain()) {
-        Main = MaybeMain;
-        break;
-      }
-    }
-
-    if (!Main)
-      throw FireError("fire::fire_llvm must be called inside 'main'", FireCall);
-
-    // Replace main function.
-
     std::string FireMain;
 
     auto FireCallArgDecl { FireCallArg->getDecl() };
@@ -112,7 +161,11 @@ public:
       auto Value { llvm::dyn_cast<clang::ValueDecl>(FireCallArgDecl) };
 
       auto Record { Value->getType()->getAsCXXRecordDecl() };
-      auto RecordInstance { Value->getNameAsString() };
+
+      // Qualify the instance so that launchpad locals can not shadow it.
+      auto RecordInstance { Value->getDeclContext()->isFileContext()
+                              ? print::name(Context_, Value)
+                              : Value->getNameAsString() };
 
       if (Record)
         FireMain = fireMainRecord(Record, RecordInstance);
@@ -121,312 +174,1607 @@ public:
     if (FireMain.empty())
       throw FireError("fire::fire_llvm expects a function or class type argument", FireCall);
 
-    FileRewriter_->ReplaceText(Main->getSourceRange(), FireMain);
-
-    // Obtain file ID of main function.
-
-    auto &SourceManager { Context_.getSourceManager() };
+    stats::count(Stats_, stats::GlueBytes, FireMain.size());
 
-    *FileID_ = SourceManager.getFileID(Main->getBeginLoc());
+    return FireMain;
   }
 
 private:
-  std::string fireMainFunction(clang::FunctionDecl const *Function) const
+  struct FireParam
   {
-    auto FunctionName { Function->getName() };
+    // Option name, or parameter name for variadic parameters.
+    std::string Name;
 
-    for (auto Param : Function->parameters())
-      FileRewriter_->ReplaceText(Param->getSourceRange(), fireParam(Param));
+    // fire::runtime::param_kind enumerator.
+    std::string Kind;
+
+    // Type the argument is converted to.
+    std::string Type;
+
+    // Name of the accepted values in usage messages.
+    std::string ValueName;
+
+    // Default argument, empty if there is none.
+    std::string Default;
+
+    // Documentation from the function's doc comment.
+    std::string Help;
+
+    // Whether the option must be given.
+    bool Required;
+
+    // Whether the parameter binds to a non-const lvalue reference.
+    bool LValueReference;
+  };
 
-    return llvm::formatv("FIRE({0})", FunctionName);
+  // Fired class that is only constructed by a launchpad once it has bound
+  // and converted all arguments.
+  struct FireLazyRecord
+  {
+    // Qualified name of the class.
+    std::string Type;
+
+    // Constructor whose parameters are additional options of every
+    // launchpad, nullptr if the class is default constructed.
+    clang::CXXConstructorDecl const *Constructor;
+  };
+
+  // Name of the lazily constructed instance, local to every launchpad.
+  static constexpr char const *LazyInstance { "fire_instance" };
+
+  std::string fireMainType(clang::CallExpr const *FireCall) const
+  {
+    auto TemplateArgs { FireCall->getDirectCallee()->getTemplateSpecializationArgs() };
+
+    clang::CXXRecordDecl const *Record { nullptr };
+
+    if (TemplateArgs && TemplateArgs->size() == 1 &&
+        TemplateArgs->get(0).getKind() == clang::TemplateArgument::Type) {
+      Record = TemplateArgs->get(0).getAsType()->getAsCXXRecordDecl();
+    }
+
+    if (!Record || !Record->hasDefinition())
+      throw FireError("fire::fire_llvm expects a class type template argument", FireCall);
+
+    auto Constructors { record::publicConstructors(Record) };
+    if (Constructors.size() > 1) {
+      throw FireError("Fired class must not have more than one public "
+                      "constructor besides copy and move constructors", Record);
+    }
+
+    FireLazyRecord Lazy { print::name(Context_, Record),
+                          Constructors.empty() ? nullptr : Constructors[0] };
+
+    auto FireMain { fireMainRecord(Record, LazyInstance, &Lazy) };
+
+    stats::count(Stats_, stats::GlueBytes, FireMain.size());
+
+    return FireMain;
   }
 
-  std::string fireMainRecord(clang::CXXRecordDecl const *Record,
-                             std::string const &RecordInstance) const
+  std::string fireMainFunction(clang::FunctionDecl const *Function) const
   {
-    // Public methods.
-    auto [publicMethods, publicMethodOptions] = record::publicMethods(Record);
+    auto LaunchName { symbol() };
+
+    // Launchpad function.
+    auto Launchpad { fireLaunchpad(LaunchName, print::name(Context_, Function), Function) };
 
-    // Code generation helper functions.
+    std::stringstream SS;
 
-    auto RecordName { Record->getNameAsString() };
+    // Conversions of enumeration parameters.
+    SS << fireEnums();
 
-    // Names of forwarding launchpad functions.
-    auto Launch = [&RecordName](std::string const &MethodName, bool Fire = false)
-    { return RecordName + "_" + MethodName + (Fire ? "_fire" : ""); };
+    // Begin detail namespace.
+    SS << "namespace fire::detail {\n\n";
 
-    // Name of new main entry point.
-    auto LaunchEntry = [&RecordName]()
-    { return RecordName + "_main"; };
+    SS << Launchpad;
 
-    // Code generation.
+    // End detail namespace.
+    SS << "} // end namespace fire::detail\n\n";
+
+    // New main function.
+    SS << fireEntry(LaunchName);
+
+    return SS.str();
+  }
+
+  std::string fireMainRecord(clang::CXXRecordDecl const *Record,
+                             std::string const &RecordInstance,
+                             FireLazyRecord const *Lazy = nullptr) const
+  {
+    // Launchpad functions and entry points.
+    std::stringstream RecordSS;
+
+    auto LaunchEntry { fireRecord(Record, RecordInstance, Lazy, RecordSS) };
 
     std::stringstream SS;
 
+    // Conversions of enumeration parameters.
+    SS << fireEnums();
+
     // Begin detail namespace.
     SS << "namespace fire::detail {\n\n";
 
-    // Launchpad functions.
-    for (auto Method : publicMethods) {
-      auto MethodName { Method->getNameAsString() };
-      auto MethodReturnType { print::type(Context_, Method->getReturnType()) };
-      auto MethodNumParams { Method->getNumParams() };
+    SS << RecordSS.str();
 
-      // Launchpad function header.
-      SS << MethodReturnType << " " << Launch(MethodName);
+    // End detail namespace.
+    SS << "} // end namespace fire::detail\n\n";
 
-      SS << "(";
-      for (unsigned i { 0 }; i < MethodNumParams; ++i) {
-        auto MethodParam { Method->getParamDecl(i) };
+    // New main function.
+    SS << fireEntry(LaunchEntry);
 
-        SS << fireParam(MethodParam);
+    return SS.str();
+  }
 
-        if (i + 1 < MethodNumParams)
-          SS << ", ";
-      }
-      SS << ")\n";
+  // Generates launchpads for the public methods of a record and, recursively,
+  // entry points for its public data members of record type. Every entry
+  // point dispatches on a single command through its own perfect hash table,
+  // i.e. a path of subcommands is resolved with one lookup per level
+  // regardless of the total number of commands. Returns the name of the
+  // record's entry point.
+  std::string fireRecord(clang::CXXRecordDecl const *Record,
+                         std::string const &RecordInstance,
+                         FireLazyRecord const *Lazy,
+                         std::stringstream &SS) const
+  {
+    // Public methods and subcommands.
+    auto PublicMethodOverloads { record::publicMethodOverloads(Record) };
+    auto PublicRecordFields { record::publicRecordFields(Record) };
 
-      // Launchpad function body.
-      SS << "{ ";
+    // Name of this record's entry point.
+    auto LaunchEntry { symbol() };
 
-      if (MethodReturnType != "void")
-        SS << "return ";
+    // Code generation.
 
-      SS << RecordInstance << "." << MethodName;
+    // Commands, mapped to the functions they are dispatched to.
+    std::vector<std::string> CommandNames;
+    std::vector<std::string> CommandHelps;
+    std::vector<std::string> CommandTargets;
+
+    auto AddCommand = [&](std::string const &CommandName,
+                          clang::NamedDecl const *Decl,
+                          std::string const &Target)
+    {
+      CommandNames.push_back(CommandName);
+      CommandHelps.push_back(comment::parse(Context_, Decl).Brief);
+      CommandTargets.push_back(Target);
+
+      if (Completion_)
+        Completion_->add(LaunchEntry, CommandName, Target);
+    };
 
-      SS << "(";
-      for (unsigned i { 0 }; i < MethodNumParams; ++i) {
-        auto MethodParam { Method->getParamDecl(i) };
-        auto MethodParamName { MethodParam->getNameAsString() };
+    // Launchpad functions.
+    for (auto const &Overloads : PublicMethodOverloads) {
+      auto MethodName { Overloads[0]->getNameAsString() };
+      auto LaunchName { symbol() };
+
+      if (Overloads.size() == 1) {
+        SS << fireLaunchpad(LaunchName,
+                            RecordInstance + "." + MethodName,
+                            Overloads[0],
+                            Lazy);
+      } else {
+        SS << fireOverloads(LaunchName,
+                            RecordInstance + "." + MethodName,
+                            Overloads,
+                            Lazy);
+      }
 
-        SS << MethodParamName;
+      AddCommand(MethodName, Overloads[0], LaunchName);
+    }
 
-        if (i + 1 < MethodNumParams)
-          SS << ", ";
+    // Nested entry points, these must precede the entry point calling them.
+    for (auto Field : PublicRecordFields) {
+      auto FieldName { Field->getNameAsString() };
+      auto FieldRecord { Field->getType()->getAsCXXRecordDecl() };
+
+      if (record::publicMethods(FieldRecord).empty() &&
+          record::publicRecordFields(FieldRecord).empty())
+        continue;
+
+      if (std::find(CommandNames.begin(), CommandNames.end(), FieldName) != CommandNames.end())
+        throw FireError("Member '" + FieldName + "' has the same name as a method", Field);
+
+      // Members of types that were not written with a CLI in mind (e.g. a
+      // mutex or a third party container) are skipped with a warning instead
+      // of failing the whole program.
+      std::stringstream FieldSS;
+      std::string FieldEntry;
+
+      auto ThunksSize { Thunks_ ? Thunks_->size() : 0 };
+      auto EnumsSize { Enums_.size() };
+
+      try {
+        FieldEntry = fireRecord(FieldRecord,
+                                RecordInstance + "." + FieldName,
+                                Lazy,
+                                FieldSS);
+      } catch (FireSplitError const &) {
+        throw;
+      } catch (FireError const &e) {
+        if (Thunks_)
+          Thunks_->resize(ThunksSize);
+
+        Enums_.resize(EnumsSize);
+
+        Warnings_.emplace_back("Member '" + FieldName + "' is not exposed as a "
+                               "subcommand: " + e.what(), Field);
+        continue;
       }
-      SS << ")";
 
-      SS << "; }\n\n";
+      SS << FieldSS.str();
+
+      AddCommand(FieldName, Field, FieldEntry);
+    }
+
+    // Command name perfect hash table.
+    auto CommandHash { dispatch::perfectHash(CommandNames) };
+
+    SS << "constexpr std::uint32_t " << LaunchEntry << "_displacements[] { ";
+    for (auto Displacement : CommandHash.Displacements)
+      SS << Displacement << "u, ";
+    SS << "};\n\n";
 
-      // FIRE_LAUNCH() call.
-      std::string FireFunc {
-        llvm::formatv("FIRE_LAUNCH({0}, {1})\n\n",
-                      Launch(MethodName, true),
-                      Launch(MethodName)) };
+    SS << "constexpr std::string_view " << LaunchEntry << "_slots[] { ";
+    for (auto const &Slot : CommandHash.Slots)
+      SS << "\"" << Slot << "\", ";
+    SS << "};\n\n";
 
-      SS << FireFunc;
+    SS << "constexpr std::array<fire::runtime::command, " << CommandNames.size() << "> "
+       << LaunchEntry << "_commands {{\n";
+    for (std::size_t i { 0 }; i < CommandNames.size(); ++i) {
+      SS << "  { \"" << CommandNames[i] << "\", "
+         << print::literal(CommandHelps[i]) << " },\n";
     }
+    SS << "}};\n\n";
 
     // Entry point header.
-    std::string LaunchEntryerHeader {
-      llvm::formatv(
-        "int {0}(std::string method = fire::arg({0, \"<method>\", \"({1})\"}))\n",
-        LaunchEntry(),
-        publicMethodOptions) };
-
-    SS << LaunchEntryerHeader;
+    SS << "int " << LaunchEntry << "(fire::runtime::args &args)\n";
 
     // Entry point body.
     SS << "{\n";
 
-    for (auto Method : publicMethods) {
-      auto MethodName { Method->getNameAsString() };
+    SS << "  auto command { args.shift() };\n\n";
+
+    SS << llvm::formatv("  switch (fire::runtime::lookup(command, {0}_displacements, {0}_slots)) {{\n",
+                        LaunchEntry).str();
 
-      std::string LaunchEntryBranch {
-        llvm::formatv(
-          "if (method == \"{0}\") {1}({2}, {3});\n",
-          MethodName,
-          Launch(MethodName, true),
-          "fire::raw_args.argc() - 1",
-          "const_cast<const char **>(fire::raw_args.argv()) + 1") };
+    for (std::size_t Slot { 0 }; Slot < CommandHash.Slots.size(); ++Slot) {
+      auto const &CommandName { CommandHash.Slots[Slot] };
+      if (CommandName.empty())
+        continue;
 
-      SS << LaunchEntryBranch;
+      auto Command { std::find(CommandNames.begin(), CommandNames.end(), CommandName) };
+      auto const &Target { CommandTargets[Command - CommandNames.begin()] };
+
+      SS << "  case " << Slot << ": return " << Target << "(args);\n";
     }
 
-    SS << "  return 0;\n";
+    SS << "  }\n\n";
+
+    SS << "  return fire::runtime::no_command(args, command, "
+       << LaunchEntry << "_commands);\n";
 
     SS << "}\n\n";
 
-    // End detail namespace.
-    SS << "} // end namespace fire::detail\n\n";
+    return LaunchEntry;
+  }
 
-    // FIRE() call.
-    std::string Fire {
-      llvm::formatv("FIRE_LAUNCH_ENTRY(fire::detail::{0});", LaunchEntry()) };
+  // Parameters of a launchpad: those of the function followed by those of the
+  // constructor of a lazily constructed record.
+  std::vector<FireParam> fireParams(clang::FunctionDecl const *Function,
+                                    FireLazyRecord const *Lazy) const
+  {
+    std::vector<FireParam> Params;
 
-    SS << Fire;
+    auto Comment { comment::parse(Context_, Function) };
 
-    return SS.str();
+    for (auto Param : Function->parameters())
+      Params.push_back(fireParam(Param, Comment));
+
+    if (!Lazy || !Lazy->Constructor)
+      return Params;
+
+    auto ConstructorComment { comment::parse(Context_, Lazy->Constructor) };
+
+    for (auto Param : Lazy->Constructor->parameters()) {
+      auto FP { fireParam(Param, ConstructorComment) };
+
+      for (std::size_t i { 0 }; i < Function->getNumParams(); ++i) {
+        if (Params[i].Name == FP.Name ||
+            (Params[i].Kind == "variadic" && FP.Kind == "variadic")) {
+          throw FireError("Parameter '" + Param->getNameAsString() +
+                          "' conflicts with a constructor parameter",
+                          Function->getParamDecl(i));
+        }
+      }
+
+      Params.push_back(FP);
+    }
+
+    return Params;
   }
 
-  std::string fireParam(clang::ParmVarDecl const *Param) const
+  // Generates a schema of the function's parameters and a launchpad which
+  // binds the command line arguments to it and forwards them to the function.
+  // When splitting, the launchpad forwards the converted arguments to a thunk
+  // instead, which is emitted into the user's translation unit and calls the
+  // function there.
+  std::string fireLaunchpad(std::string const &LaunchName,
+                            std::string const &Callee,
+                            clang::FunctionDecl const *Function,
+                            FireLazyRecord const *Lazy = nullptr) const
   {
-    // Obtain parameter name/type/default value.
+    auto Comment { comment::parse(Context_, Function) };
 
-    auto ParamName { Param->getName() };
-    if (ParamName.empty())
-        throw FireError("Parameter must not be unnamed", Param);
+    auto Params { fireParams(Function, Lazy) };
 
-    auto ParamType { Param->getType() };
-    if (ParamType->isLValueReferenceType() &&
-        ParamType.getNonReferenceType().isConstQualified())
-      ParamType = ParamType.getNonReferenceType();
+    stats::count(Stats_, stats::Launchpads);
+    stats::count(Stats_, stats::Params, Params.size());
 
-    std::string ParamDefault;
-    if (Param->hasDefaultArg())
-      ParamDefault = print::source(Context_, Param->getDefaultArgRange());
+    auto Schema { LaunchName + "_params" };
+    auto Help { LaunchName + "_help" };
+    auto Thunk { LaunchName + "_invoke" };
+
+    // Type of the thunk parameters, defaults are only evaluated by the thunk.
+    auto ThunkParamType = [](FireParam const &Param)
+    {
+      return Param.Default.empty() ? Param.Type
+                                   : "std::optional<" + Param.Type + ">";
+    };
+
+    for (auto const &Param : Params)
+      fireCompletion(LaunchName, Param);
+
+    std::stringstream SS;
+
+    // Parameter schema and help text.
+    SS << "constexpr std::array<fire::runtime::param, " << Params.size() << "> "
+       << Schema << " {";
+
+    if (!Params.empty()) {
+      SS << "{\n";
+      for (auto const &Param : Params) {
+        SS << "  { \"" << Param.Name << "\", "
+           << "fire::runtime::param_kind::" << Param.Kind << ", "
+           << "\"" << Param.ValueName << "\", "
+           << print::literal(Param.Default) << ", "
+           << print::literal(Param.Help) << ", "
+           << (Param.Required ? "true" : "false") << " },\n";
+      }
+      SS << "}";
+    }
 
-    // Construct fire parameter name/type/default value.
+    SS << "};\n\n";
 
-    std::string FireParamName { ParamName };
+    SS << "constexpr std::string_view " << Help << " { "
+       << print::literal(Comment.Brief) << " };\n\n";
 
-    std::string FireParamType { print::type(Context_, Param->getType()) };
+    // Thunk declaration.
+    if (Thunks_) {
+      SS << "void " << Thunk << "(";
+      for (std::size_t i { 0 }; i < Params.size(); ++i)
+        SS << (i > 0 ? ", " : "") << ThunkParamType(Params[i]);
+      SS << ");\n\n";
+    }
 
-    std::string FireParamDefault;
+    // Launchpad function header.
+    SS << "int " << LaunchName << "(fire::runtime::args &args)\n";
 
-    if (type::isTemplate(ParamType, "vector", "std")) {
-      FireParamDefault = "fire::arg(fire::variadic())";
+    // Launchpad function body.
+    SS << "{\n";
 
-    } else {
-      if (type::isTemplate(ParamType, "optional", "std")) {
-        str::replace(FireParamType, "std::optional", "fire::optional");
+    SS << "  std::array<fire::runtime::slot, " << Params.size() << "> slots;\n\n";
 
-      } else if (!type::is(ParamType, "basic_string") &&
-                 !ParamType->isBooleanType() &&
-                 !ParamType->isIntegerType() &&
-                 !ParamType->isFloatingType()) {
+    SS << "  if (!args.bind(" << Schema << ", slots, " << Help << "))\n"
+       << "    return 0;\n\n";
 
-        throw FireError(
-          "Parameter must have boolean, integral or floating point type or be"
-          "one of std::string, std::vector, std::optional", Param);
+    for (std::size_t i { 0 }; i < Params.size(); ++i) {
+      auto const &Param { Params[i] };
+
+      if (Thunks_) {
+        SS << "  auto p" << i << " { fire::runtime::"
+           << (Param.Default.empty() ? "get<" : "get_if_present<") << Param.Type << ">"
+           << "(args, " << Schema << "[" << i << "], slots[" << i << "]) };\n";
+        continue;
       }
 
-      auto FireParamDash { FireParamName.size() > 1 ? "--" : "-" };
+      SS << "  auto p" << i << " { fire::runtime::get<" << Param.Type << ">"
+         << "(args, " << Schema << "[" << i << "], slots[" << i << "]";
 
-      if (ParamDefault.empty()) {
-        FireParamDefault = llvm::formatv("fire::arg(\"{0}{1}\")",
-                                         FireParamDash,
-                                         FireParamName);
-      } else {
-        FireParamDefault = llvm::formatv("fire::arg(\"{0}{1}\", {2})",
-                                         FireParamDash,
-                                         FireParamName,
-                                         ParamDefault);
+      if (!Param.Default.empty())
+        SS << ", []() -> " << Param.Type << " { return " << Param.Default << "; }";
+
+      SS << ") };\n";
+    }
+
+    if (!Params.empty())
+      SS << "\n";
+
+    if (Thunks_) {
+      SS << "  " << Thunk << "(";
+      for (std::size_t i { 0 }; i < Params.size(); ++i)
+        SS << (i > 0 ? ", " : "") << "std::move(p" << i << ")";
+      SS << ");\n\n";
+
+    } else {
+      SS << fireCall(Callee, Function, Params, Lazy);
+    }
+
+    SS << "  return 0;\n";
+
+    SS << "}\n\n";
+
+    if (Thunks_) {
+      std::stringstream ThunkSS;
+
+      ThunkSS << "void " << Thunk << "(";
+      for (std::size_t i { 0 }; i < Params.size(); ++i)
+        ThunkSS << (i > 0 ? ", " : "") << ThunkParamType(Params[i]) << " a" << i;
+      ThunkSS << ")\n";
+
+      ThunkSS << "{\n";
+
+      for (std::size_t i { 0 }; i < Params.size(); ++i) {
+        auto const &Param { Params[i] };
+
+        ThunkSS << "  auto p" << i << " { ";
+
+        if (Param.Default.empty()) {
+          ThunkSS << "std::move(a" << i << ")";
+        } else {
+          ThunkSS << "a" << i << " ? std::move(*a" << i << ") : []() -> "
+                  << Param.Type << " { return " << Param.Default << "; }()";
+        }
+
+        ThunkSS << " };\n";
       }
+
+      if (!Params.empty())
+        ThunkSS << "\n";
+
+      ThunkSS << fireCall(Callee, Function, Params, Lazy);
+
+      ThunkSS << "}\n\n";
+
+      *Thunks_ += ThunkSS.str();
     }
 
-    return llvm::formatv("{0} {1} = {2}",
-                         FireParamType,
-                         FireParamName,
-                         FireParamDefault);
+    return SS.str();
   }
 
-  clang::ASTContext &Context_;
-  clang::FileID *FileID_;
-  clang::Rewriter *FileRewriter_;
-};
+  // Calls the function with the converted arguments p0, p1, ... and prints
+  // the result, constructing the instance first if it is lazily constructed.
+  std::string fireCall(std::string const &Callee,
+                       clang::FunctionDecl const *Function,
+                       std::vector<FireParam> const &Params,
+                       FireLazyRecord const *Lazy) const
+  {
+    auto Arguments = [&Params](std::size_t First, std::size_t Last)
+    {
+      std::stringstream Args;
+
+      for (std::size_t i { First }; i < Last; ++i) {
+        if (Params[i].LValueReference)
+          Args << "p" << i;
+        else
+          Args << "std::move(p" << i << ")";
+
+        if (i + 1 < Last)
+          Args << ", ";
+      }
 
-class FireConsumer : public clang::ASTConsumer
-{
-public:
-  FireConsumer(clang::FileID *FileID,
-               clang::Rewriter *FileRewriter,
-               bool *FileRewriteError)
-  : FileID_(FileID),
-    FileRewriter_(FileRewriter),
-    FileRewriteError_(FileRewriteError)
-  {}
+      return Args.str();
+    };
 
-  void HandleTranslationUnit(clang::ASTContext &Context) override
+    auto NumCallParams { Function->getNumParams() };
+
+    std::stringstream SS;
+
+    // The instance is only constructed once all arguments are valid.
+    if (Lazy) {
+      SS << "  " << Lazy->Type << " " << LazyInstance;
+
+      if (NumCallParams < Params.size())
+        SS << "(" << Arguments(NumCallParams, Params.size()) << ");\n\n";
+      else
+        SS << " {};\n\n";
+    }
+
+    SS << "  fire::runtime::print_result([&]() -> decltype(auto) { return "
+       << Callee << "(" << Arguments(0, NumCallParams) << "); });\n\n";
+
+    return SS.str();
+  }
+
+  // Generates one launchpad per overload and a launchpad selecting one of
+  // them. Overloads are told apart by the options given and whether there are
+  // positional arguments: the plugin precomputes the chosen overload for
+  // every combination of these, so selecting one costs a single pass over
+  // the arguments and a table lookup. If several overloads accept the given
+  // arguments, the one accepting the fewest options is chosen.
+  std::string fireOverloads(std::string const &LaunchName,
+                            std::string const &Callee,
+                            std::vector<clang::CXXMethodDecl const *> const &Overloads,
+                            FireLazyRecord const *Lazy = nullptr) const
   {
-    using namespace clang::ast_matchers;
-
-    // create match expression
-    auto FireMatchExpression {
-      callExpr(
-        callee(
-          functionDecl(
-            allOf(
-              hasName("fire_llvm"),
-              hasParent(
-                functionTemplateDecl(
-                  hasParent(
-                    namespaceDecl(
-                      hasName("fire")))))))))
+    constexpr std::size_t MaxOptions { 12 };
+
+    struct Signature
+    {
+      unsigned Accepted = 0;
+      unsigned Required = 0;
+      bool Variadic = false;
     };
 
-    // create match callback
-    FireMatchCallback MatchCallback(Context, FileID_, FileRewriter_);
+    // Options of all overloads.
+    std::vector<FireParam> Options;
+    std::vector<Signature> Signatures;
 
-    // create and run match finder
-    clang::ast_matchers::MatchFinder MatchFinder;
-    MatchFinder.addMatcher(FireMatchExpression.bind("fire"), &MatchCallback);
+    for (auto Overload : Overloads) {
+      Signature Sig;
 
-    try {
-      MatchFinder.matchAST(Context);
+      for (auto const &FP : fireParams(Overload, Lazy)) {
+        if (FP.Kind == "variadic") {
+          Sig.Variadic = true;
+          continue;
+        }
 
-      *FileRewriteError_ = false;
+        auto Option { std::find_if(Options.begin(), Options.end(),
+                                   [&FP](FireParam const &Option)
+                                   { return Option.Name == FP.Name; }) };
 
-    } catch (FireError const &e) {
-      auto &Diags { Context.getDiagnostics() };
+        if (Option == Options.end()) {
+          if (Options.size() == MaxOptions)
+            throw FireError("Overloads must not have more than " +
+                            std::to_string(MaxOptions) + " distinct parameters", Overload);
 
-      unsigned ID { Diags.getDiagnosticIDs()->getCustomDiagID(
-                      clang::DiagnosticIDs::Error, e.what()) };
+          Option = Options.insert(Options.end(), FP);
 
-      Diags.Report(e.where(), ID);
+        } else if (Option->Kind != FP.Kind) {
+          throw FireError("Overloads must not have boolean and non-boolean "
+                          "parameters of the same name", Overload);
+        }
 
-      *FileRewriteError_ = true;
+        unsigned Bit { 1u << (Option - Options.begin()) };
+
+        Sig.Accepted |= Bit;
+        if (FP.Required)
+          Sig.Required |= Bit;
+      }
+
+      for (auto const &Other : Signatures) {
+        if (Other.Accepted == Sig.Accepted && Other.Variadic == Sig.Variadic)
+          throw FireError("Overloads must differ in their parameter names", Overload);
+      }
+
+      Signatures.push_back(Sig);
     }
-  }
 
-private:
-  clang::FileID *FileID_;
-  clang::Rewriter *FileRewriter_;
-  bool *FileRewriteError_;
-};
+    // Decision table, indexed by the given options with an additional most
+    // significant bit indicating positional arguments. Entries are overload
+    // indices, -1 if no overload and -2 if several overloads match equally.
+    auto NumOptions { static_cast<unsigned>(Options.size()) };
 
-class FireAction : public clang::PluginASTAction
-{
-protected:
-  std::unique_ptr<clang::ASTConsumer> CreateASTConsumer(
-    clang::CompilerInstance &CI,
-    llvm::StringRef FileName) override
-  {
-    auto &SourceManager { CI.getSourceManager() };
-    auto &LangOpts { CI.getLangOpts() };
+    std::vector<int> Table(std::size_t(1) << (NumOptions + 1));
 
-    CI_ = &CI;
+    for (unsigned Mask { 0 }; Mask < Table.size(); ++Mask) {
+      unsigned Given { Mask & ((1u << NumOptions) - 1) };
+      bool Positionals { (Mask >> NumOptions) != 0 };
 
-    FileName_ = FileName.str();
+      int Best { -1 };
+      int BestCost { 0 };
 
-    FileRewriter_.setSourceMgr(SourceManager, LangOpts);
+      for (std::size_t i { 0 }; i < Signatures.size(); ++i) {
+        auto const &Sig { Signatures[i] };
 
-    return std::make_unique<FireConsumer>(
-        &FileID_, &FileRewriter_, &FileRewriteError_);
+        if ((Given & ~Sig.Accepted) || (Sig.Required & ~Given) ||
+            (Positionals && !Sig.Variadic))
+          continue;
+
+        auto Cost { static_cast<int>(std::bitset<32>(Sig.Accepted).count()) + Sig.Variadic };
+
+        if (Best == -1 || Cost < BestCost) {
+          Best = static_cast<int>(i);
+          BestCost = Cost;
+        } else if (Cost == BestCost) {
+          Best = -2;
+        }
+      }
+
+      Table[Mask] = Best;
+    }
+
+    std::stringstream SS;
+
+    // Overload launchpads.
+    std::vector<std::string> OverloadNames;
+
+    for (auto Overload : Overloads) {
+      OverloadNames.push_back(symbol());
+
+      SS << fireLaunchpad(OverloadNames.back(), Callee, Overload, Lazy);
+    }
+
+    for (auto const &Option : Options)
+      fireCompletion(LaunchName, Option);
+
+    // Options and decision table.
+    SS << "constexpr std::array<fire::runtime::param, " << Options.size() << "> "
+       << LaunchName << "_options {";
+
+    if (!Options.empty()) {
+      SS << "{\n";
+      for (auto const &Option : Options) {
+        SS << "  { \"" << Option.Name << "\", "
+           << "fire::runtime::param_kind::" << Option.Kind << " },\n";
+      }
+      SS << "}";
+    }
+
+    SS << "};\n\n";
+
+    SS << "constexpr std::array<std::int8_t, " << Table.size() << "> "
+       << LaunchName << "_overloads {{ ";
+    for (auto Entry : Table)
+      SS << Entry << ", ";
+    SS << "}};\n\n";
+
+    // Selecting launchpad.
+    SS << "int " << LaunchName << "(fire::runtime::args &args)\n";
+
+    SS << "{\n";
+
+    SS << "  if (args.help_requested())\n"
+       << "    return fire::runtime::print_overloads(args";
+    for (auto const &OverloadName : OverloadNames)
+      SS << ", " << OverloadName;
+    SS << ");\n\n";
+
+    SS << llvm::formatv("  switch (fire::runtime::select_overload(args, {0}_options, {0}_overloads)) {{\n",
+                        LaunchName).str();
+
+    for (std::size_t i { 0 }; i < Overloads.size(); ++i)
+      SS << "  case " << i << ": return " << OverloadNames[i] << "(args);\n";
+
+    SS << "  }\n\n";
+
+    SS << "  return 1;\n";
+
+    SS << "}\n\n";
+
+    return SS.str();
   }
 
-  bool ParseArgs(clang::CompilerInstance const &,
-                 std::vector<std::string> const &) override
+  // Names of launchpads and entry points. User identifiers only appear in
+  // string literals and calls of the fired code, joining them into symbol
+  // names could produce the same name twice. Schemas, help texts, thunks etc.
+  // are named by appending a fixed suffix to the name of their launchpad or
+  // entry point.
+  std::string symbol() const
+  { return "fire_launchpad_" + std::to_string(Symbols_++); }
+
+  std::string fireEntry(std::string const &LaunchEntry) const
   {
-    return true;
+    if (Completion_)
+      Completion_->root(LaunchEntry);
+
+    return llvm::formatv("int main(int argc, char **argv)\n"
+                         "{{ return fire::runtime::run(argc, argv, fire::detail::{0}); }\n",
+                         LaunchEntry);
   }
 
-  clang::PluginASTAction::ActionType getActionType() override
+  // Options are completed up to the '=' preceding their value, positional
+  // arguments are not completed.
+  void fireCompletion(std::string const &LaunchName, FireParam const &Param) const
   {
-    return clang::PluginASTAction::ReplaceAction;
+    if (!Completion_ || Param.Kind == "variadic")
+      return;
+
+    Completion_->add(LaunchName, Param.Kind == "flag" ? Param.Name : Param.Name + "=");
   }
 
-  void EndSourceFileAction() override
+  // Specializes fire::runtime::enum_names for every enumeration type seen by
+  // fireParam, so that enumerator names are converted with a single lookup in
+  // a perfect hash table.
+  std::string fireEnums() const
   {
-    if (FileRewriteError_)
-      return;
+    if (Enums_.empty())
+      return "";
+
+    std::stringstream SS;
+
+    SS << "namespace fire::runtime {\n\n";
+
+    for (auto Enum : Enums_) {
+      auto EnumName { print::name(Context_, Enum) };
 
-    auto FileRewriteBuffer { FileRewriter_.getRewriteBufferFor(FileID_) };
+      std::vector<std::string> Enumerators;
+      for (auto Enumerator : Enum->enumerators())
+        Enumerators.push_back(Enumerator->getNameAsString());
 
-    compile(CI_, FileName_, FileRewriteBuffer->begin(), FileRewriteBuffer->end());
+      auto EnumeratorHash { dispatch::perfectHash(Enumerators) };
+
+      SS << "template<>\n"
+         << "struct enum_names<" << EnumName << ">\n"
+         << "{\n";
+
+      SS << "  static constexpr std::uint32_t displacements[] { ";
+      for (auto Displacement : EnumeratorHash.Displacements)
+        SS << Displacement << "u, ";
+      SS << "};\n\n";
+
+      SS << "  static constexpr std::string_view slots[] { ";
+      for (auto const &Slot : EnumeratorHash.Slots)
+        SS << "\"" << Slot << "\", ";
+      SS << "};\n\n";
+
+      SS << "  static constexpr " << EnumName << " values[] { ";
+      for (auto const &Slot : EnumeratorHash.Slots) {
+        if (Slot.empty())
+          SS << EnumName << " {}, ";
+        else
+          SS << EnumName << "::" << Slot << ", ";
+      }
+      SS << "};\n";
+
+      SS << "};\n\n";
+    }
+
+    SS << "} // end namespace fire::runtime\n\n";
+
+    return SS.str();
   }
 
-private:
+  FireParam fireParam(clang::ParmVarDecl const *Param,
+                      comment::Comment const &Comment) const
+  {
+    // Obtain parameter name/type/default value.
+
+    auto ParamName { Param->getNameAsString() };
+    if (ParamName.empty())
+        throw FireError("Parameter must not be unnamed", Param);
+
+    auto ParamType { Param->getType() };
+
+    bool ParamLValueReference { ParamType->isLValueReferenceType() &&
+                                !ParamType.getNonReferenceType().isConstQualified() };
+
+    ParamType = ParamType.getNonReferenceType().getUnqualifiedType();
+
+    std::string ParamDefault;
+    if (Param->hasDefaultArg())
+      ParamDefault = print::source(Context_, Param->getDefaultArgRange());
+
+    // Construct fire parameter schema entry.
+
+    // The glue's own translation unit only sees canonical types.
+    auto ParamTypeName { print::type(Context_, Thunks_ ? ParamType.getCanonicalType()
+                                                       : ParamType) };
+
+    // Type converted from a single command line value.
+    auto ValueType { ParamType };
+
+    if (type::isTemplate(ParamType, "optional", "std") ||
+        type::isTemplate(ParamType, "vector", "std")) {
+      auto Element { type::templateArgument(ParamType, 0) };
+      if (!Element.isNull())
+        ValueType = Element;
+    }
+
+    bool ValueParser { type::hasParser(Context_, ValueType) };
+
+    if (Thunks_) {
+      if (ValueParser)
+        throw FireSplitError("parameter types with a user-provided parser can not be split, "
+                             "the glue is compiled into this translation unit instead", Param);
+
+      if (!type::isStandalone(ParamType))
+        throw FireSplitError("parameter type can not be used in a split translation unit, "
+                             "the glue is compiled into this translation unit instead", Param);
+    }
+
+    // Enumerations, also as elements of optionals and vectors, are converted
+    // from the names of their enumerators.
+    if (auto Enum { ValueType->getAs<clang::EnumType>() }) {
+      auto EnumDecl { Enum->getDecl()->getDefinition() };
+      if (!EnumDecl)
+        throw FireError("Parameter must not have incomplete enumeration type", Param);
+
+      if (std::find(Enums_.begin(), Enums_.end(), EnumDecl) == Enums_.end())
+        Enums_.push_back(EnumDecl);
+    }
+
+    FireParam FP { "", "", ParamTypeName,
+                   type::valueName(ParamType), ParamDefault,
+                   Comment.param(ParamName), false, ParamLValueReference };
+
+    if (type::isTemplate(ParamType, "vector", "std") ||
+        type::isTemplate(ParamType, "span", "std")) {
+      FP.Name = ParamName;
+      FP.Kind = "variadic";
+
+    } else {
+      if (!type::isTemplate(ParamType, "optional", "std") &&
+          !type::isTemplate(ParamType, "stream", "fire") &&
+          !type::is(ParamType, "basic_string") &&
+          !type::is(ParamType, "basic_string_view") &&
+          !ParamType->isEnumeralType() &&
+          !ParamType->isBooleanType() &&
+          !ParamType->isIntegerType() &&
+          !ParamType->isFloatingType() &&
+          !ValueParser) {
+
+        throw FireError(
+          "Parameter must have boolean, integral, floating point or enumeration "
+          "type, be one of std::string, std::string_view, std::vector, "
+          "std::span, std::optional, fire::stream or have a fire::parser "
+          "specialization or fire_parse overload", Param);
+      }
+
+      FP.Name = (ParamName.size() > 1 ? "--" : "-") + ParamName;
+      FP.Kind = ParamType->isBooleanType() ? "flag" : "value";
+
+      FP.Required = !ParamType->isBooleanType() &&
+                    ParamDefault.empty() &&
+                    !type::isTemplate(ParamType, "optional", "std") &&
+                    !type::isTemplate(ParamType, "stream", "fire");
+    }
+
+    return FP;
+  }
+
+  clang::ASTContext &Context_;
+  stats::Stats *Stats_;
+  std::string *Thunks_;
+  completion::Index *Completion_;
+
+  // Number of symbols generated so far.
+  mutable unsigned Symbols_ = 0;
+
+  // Enumeration types of parameters, in order of appearance.
+  mutable std::vector<clang::EnumDecl const *> Enums_;
+
+  mutable std::vector<FireError> Warnings_;
+};
+
+class FireConsumer : public clang::ASTConsumer
+{
+public:
+  FireConsumer(clang::FileID *FileID,
+               clang::Rewriter *FileRewriter,
+               bool *FileRewriteError,
+               completion::Index *Completion,
+               stats::Stats *Stats)
+  : FileID_(FileID),
+    FileRewriter_(FileRewriter),
+    FileRewriteError_(FileRewriteError),
+    Completion_(Completion),
+    Stats_(Stats)
+  {}
+
+  void Initialize(clang::ASTContext &Context) override
+  { Context_ = &Context; }
+
+  bool HandleTopLevelDecl(clang::DeclGroupRef DG) override
+  {
+    auto &SourceManager { Context_->getSourceManager() };
+
+    for (auto D : DG) {
+      clang::CallExpr const *FireCall;
+
+      {
+        stats::Scope Scope(Stats_, stats::FindCall);
+
+        FireCall = call::findFire(SourceManager, D);
+      }
+
+      if (!FireCall)
+        continue;
+
+      FireFound_ = true;
+
+      try {
+        auto Main { llvm::cast<clang::FunctionDecl>(D) };
+        if (!Main->isMain())
+          throw FireError("fire::fire_llvm must be called inside 'main'", FireCall);
+
+        // Replace main function.
+
+        FireGlue Glue(*Context_, Stats_, nullptr, Completion_);
+
+        auto FireMain { Glue.fireMain(FireCall) };
+
+        reportFireWarnings(Context_->getDiagnostics(), Glue.warnings());
+
+        stats::count(Stats_,
+                     stats::RewrittenBytes,
+                     FileRewriter_->getRangeSize(Main->getSourceRange()));
+
+        FileRewriter_->ReplaceText(Main->getSourceRange(), FireMain);
+
+        // Obtain file ID of main function.
+
+        *FileID_ = SourceManager.getFileID(Main->getBeginLoc());
+
+      } catch (FireError const &e) {
+        reportFireError(Context_->getDiagnostics(), e);
+
+        *FileRewriteError_ = true;
+      }
+    }
+
+    return true;
+  }
+
+  void HandleTranslationUnit(clang::ASTContext &Context) override
+  {
+    if (!FireFound_ && reportMisplacedFire(Context))
+      *FileRewriteError_ = true;
+  }
+
+private:
+  clang::ASTContext *Context_ = nullptr;
+  clang::FileID *FileID_;
+  clang::Rewriter *FileRewriter_;
+  bool *FileRewriteError_;
+  completion::Index *Completion_;
+  stats::Stats *Stats_;
+  bool FireFound_ = false;
+};
+
+// Appended to the main file in Sema mode. The empty declaration guarantees
+// that all user declarations have been handed to the AST consumer by the time
+// the preprocessor reaches the pragma, which then splices in the fire glue.
+constexpr char const *FireGlueSentinel {
+  "\n"
+  "#pragma clang diagnostic push\n"
+  "#pragma clang diagnostic ignored \"-Wc++98-compat-extra-semi\"\n"
+  ";\n"
+  "#pragma clang diagnostic pop\n"
+  "#pragma fire_llvm_glue\n"
+};
+
+class FireGluePragmaHandler : public clang::PragmaHandler
+{
+public:
+  FireGluePragmaHandler(std::string const *Glue)
+  : clang::PragmaHandler("fire_llvm_glue"),
+    Glue_(Glue)
+  {}
+
+  void HandlePragma(clang::Preprocessor &PP,
+                    clang::PragmaIntroducer,
+                    clang::Token &PragmaTok) override
+  {
+    clang::Token Tok;
+    do {
+      PP.LexUnexpandedToken(Tok);
+    } while (Tok.isNot(clang::tok::eod));
+
+    if (Glue_->empty())
+      return;
+
+    // Lex the glue as if it had been #include'd at the pragma location.
+    auto &SourceManager { PP.getSourceManager() };
+
+    auto GlueBuffer {
+      llvm::MemoryBuffer::getMemBufferCopy(*Glue_, "<fire-llvm-glue>") };
+
+    auto GlueFileID { SourceManager.createFileID(std::move(GlueBuffer),
+                                                 clang::SrcMgr::C_User,
+                                                 0,
+                                                 0,
+                                                 PragmaTok.getLocation()) };
+
+    PP.EnterSourceFile(GlueFileID, nullptr, PragmaTok.getLocation());
+  }
+
+private:
+  std::string const *Glue_;
+};
+
+class FireSemaConsumer : public clang::ASTConsumer
+{
+public:
+  // If SplitGlue is not null, the glue is written to it instead and only the
+  // thunks it calls are injected, SplitGlueReady is invoked as soon as it
+  // has been generated.
+  FireSemaConsumer(std::string *Glue,
+                   std::string *SplitGlue,
+                   std::function<void()> SplitGlueReady,
+                   completion::Index *Completion,
+                   stats::Stats *Stats)
+  : Glue_(Glue),
+    SplitGlue_(SplitGlue),
+    SplitGlueReady_(std::move(SplitGlueReady)),
+    Completion_(Completion),
+    Stats_(Stats)
+  {}
+
+  void Initialize(clang::ASTContext &Context) override
+  { Context_ = &Context; }
+
+  bool HandleTopLevelDecl(clang::DeclGroupRef DG) override
+  {
+    auto &SourceManager { Context_->getSourceManager() };
+
+    for (auto D : DG) {
+      clang::CallExpr const *FireCall;
+
+      {
+        stats::Scope Scope(Stats_, stats::FindCall);
+
+        FireCall = call::findFire(SourceManager, D);
+      }
+
+      if (!FireCall) {
+        // The renamed 'main' does not call fire::fire_llvm, it still has to
+        // be called by a 'main' defined in place of the glue.
+        auto Function { llvm::dyn_cast<clang::FunctionDecl>(D) };
+
+        if (!FireFound_ && Function && usermain::is(Function) &&
+            Function->isThisDeclarationADefinition())
+          *Glue_ = usermain::forward(Function, Context_->getPrintingPolicy());
+
+        continue;
+      }
+
+      FireFound_ = true;
+
+      auto Function { llvm::cast<clang::FunctionDecl>(D) };
+
+      try {
+        // The user's 'main' has been renamed before parsing, if it could not
+        // be located, the glue is not injected.
+        if (Function->isMain())
+          throw FireError("the definition of 'main' calling fire::fire_llvm could "
+                          "not be located in the main file", FireCall);
+
+        if (!usermain::is(Function))
+          throw FireError("fire::fire_llvm must be called inside 'main'", FireCall);
+
+        bool Split { SplitGlue_ != nullptr };
+
+        if (Split) {
+          try {
+            std::string Thunks;
+
+            FireGlue Glue(*Context_, Stats_, &Thunks, Completion_);
+
+            *SplitGlue_ = split::source(Glue.fireMain(FireCall));
+
+            *Glue_ = "namespace fire::detail {\n\n" + Thunks +
+                     "} // end namespace fire::detail\n";
+
+            reportFireWarnings(Context_->getDiagnostics(), Glue.warnings());
+
+          } catch (FireSplitError const &e) {
+            reportFireError(Context_->getDiagnostics(), e, clang::DiagnosticIDs::Warning);
+
+            // The glue object is still linked, leave it empty.
+            *SplitGlue_ = "";
+
+            Split = false;
+          }
+
+          SplitGlueReady_();
+        }
+
+        if (!Split) {
+          FireGlue Glue(*Context_, Stats_, nullptr, Completion_);
+
+          *Glue_ = Glue.fireMain(FireCall);
+
+          reportFireWarnings(Context_->getDiagnostics(), Glue.warnings());
+        }
+
+      } catch (FireError const &e) {
+        reportFireError(Context_->getDiagnostics(), e);
+      }
+    }
+
+    return true;
+  }
+
+  void HandleTranslationUnit(clang::ASTContext &Context) override
+  {
+    if (!FireFound_)
+      reportMisplacedFire(Context);
+  }
+
+private:
+  clang::ASTContext *Context_ = nullptr;
+  std::string *Glue_;
+  std::string *SplitGlue_;
+  std::function<void()> SplitGlueReady_;
+  completion::Index *Completion_;
+  stats::Stats *Stats_;
+  bool FireFound_ = false;
+};
+
+// Used for translation units whose main file does not mention fire_llvm. A
+// fire call can then only have been expanded from a macro defined elsewhere,
+// which is reported since the glue could not be injected for it. The main
+// file is only searched if fire::fire_llvm has been declared at all.
+class FireMacroConsumer : public clang::ASTConsumer
+{
+public:
+  void HandleTranslationUnit(clang::ASTContext &Context) override
+  {
+    auto &Idents { Context.Idents };
+    if (Idents.find("fire_llvm") == Idents.end())
+      return;
+
+    auto FireCall { call::findFireInMainFile(Context) };
+    if (!FireCall)
+      return;
+
+    reportFireError(Context.getDiagnostics(),
+                    FireError("fire::fire_llvm must be spelled out in the main file, "
+                              "calls expanded from macros defined elsewhere are not "
+                              "supported", FireCall));
+  }
+};
+
+class FireEmitObjAction : public clang::EmitObjAction
+{
+public:
+  using clang::EmitObjAction::CreateASTConsumer;
+};
+
+class FireCacheConsumer : public clang::MultiplexConsumer
+{
+public:
+  FireCacheConsumer(clang::CompilerInstance &CI,
+                    std::unique_ptr<clang::ASTConsumer> EmitObjConsumer,
+                    std::string const *Glue,
+                    llvm::SmallVectorImpl<char> const *Object,
+                    std::unique_ptr<llvm::raw_pwrite_stream> Output,
+                    std::string const &CacheDir,
+                    stats::Stats *Stats)
+  : clang::MultiplexConsumer(consumers(std::move(EmitObjConsumer))),
+    CI_(CI),
+    Glue_(Glue),
+    Object_(Object),
+    Output_(std::move(Output)),
+    CacheDir_(CacheDir),
+    Stats_(Stats)
+  {}
+
+  void HandleTranslationUnit(clang::ASTContext &Context) override
+  {
+    auto &Diags { Context.getDiagnostics() };
+
+    if (Diags.hasErrorOccurred())
+      return;
+
+    std::string Key;
+    std::unique_ptr<llvm::MemoryBuffer> CachedObject;
+
+    {
+      stats::Scope Scope(Stats_, stats::CacheLookup);
+
+      Key = cache::key(CI_, *Glue_);
+      CachedObject = cache::load(CacheDir_, Key);
+    }
+
+    if (CachedObject) {
+      stats::count(Stats_, stats::CacheHits);
+
+      *Output_ << CachedObject->getBuffer();
+      Output_.reset();
+      return;
+    }
+
+    stats::count(Stats_, stats::CacheMisses);
+
+    clang::MultiplexConsumer::HandleTranslationUnit(Context);
+
+    if (Diags.hasErrorOccurred())
+      return;
+
+    llvm::StringRef Object { Object_->data(), Object_->size() };
+
+    *Output_ << Object;
+    Output_.reset();
+
+    cache::store(CacheDir_, Key, Object);
+  }
+
+private:
+  static std::vector<std::unique_ptr<clang::ASTConsumer>> consumers(
+    std::unique_ptr<clang::ASTConsumer> Consumer)
+  {
+    std::vector<std::unique_ptr<clang::ASTConsumer>> Consumers;
+    Consumers.push_back(std::move(Consumer));
+
+    return Consumers;
+  }
+
+  clang::CompilerInstance &CI_;
+  std::string const *Glue_;
+  llvm::SmallVectorImpl<char> const *Object_;
+  std::unique_ptr<llvm::raw_pwrite_stream> Output_;
+  std::string CacheDir_;
+  stats::Stats *Stats_;
+};
+
+class FireAction : public clang::PluginASTAction
+{
+public:
+  ~FireAction() override
+  {
+    if (SplitThread_.joinable())
+      SplitThread_.join();
+  }
+
+protected:
+  bool BeginInvocation(clang::CompilerInstance &CI) override
+  {
+    if (!getCurrentInput().isFile())
+      return true;
+
+    auto FileName { getCurrentFile() };
+
+    auto FileBuffer { llvm::MemoryBuffer::getFile(FileName) };
+    if (!FileBuffer)
+      return true;
+
+    // A fire call has to appear in the main file, if its name does not,
+    // the translation unit is compiled as if the plugin was not loaded.
+    if ((*FileBuffer)->getBuffer().find("fire_llvm") == llvm::StringRef::npos) {
+      FileHasFireCall_ = false;
+      return true;
+    }
+
+    if (Options_.Rewrite)
+      return true;
+
+    // The glue defines 'main', rename the user's definition and append the
+    // glue sentinel to the main file.
+    auto FileContent { usermain::rename((*FileBuffer)->getBuffer(), CI.getLangOpts()) };
+    if (FileContent.empty())
+      return true;
+
+    FileContent += FireGlueSentinel;
+
+    auto FileMemoryBuffer {
+      llvm::MemoryBuffer::getMemBufferCopy(FileContent, FileName) };
+
+    auto &PreprocessorOpts { CI.getPreprocessorOpts() };
+    PreprocessorOpts.addRemappedFile(FileName, FileMemoryBuffer.release());
+
+    return true;
+  }
+
+  std::unique_ptr<clang::ASTConsumer> CreateASTConsumer(
+    clang::CompilerInstance &CI,
+    llvm::StringRef FileName) override
+  {
+    if (!FileHasFireCall_) {
+      auto EmitObjConsumer { CreateEmitObjConsumer(CI, FileName) };
+      if (!EmitObjConsumer)
+        return nullptr;
+
+      std::vector<std::unique_ptr<clang::ASTConsumer>> Consumers;
+      Consumers.push_back(std::make_unique<FireMacroConsumer>());
+      Consumers.push_back(std::move(EmitObjConsumer));
+
+      return std::make_unique<clang::MultiplexConsumer>(std::move(Consumers));
+    }
+
+    if (!Options_.Rewrite)
+      return CreateSemaConsumer(CI, FileName);
+
+    auto &SourceManager { CI.getSourceManager() };
+    auto &LangOpts { CI.getLangOpts() };
+
+    CI_ = &CI;
+
+    FileName_ = FileName.str();
+
+    FileRewriter_.setSourceMgr(SourceManager, LangOpts);
+
+    return std::make_unique<FireConsumer>(
+        &FileID_, &FileRewriter_, &FileRewriteError_, completionIndex(), &Stats_);
+  }
+
+  bool ParseArgs(clang::CompilerInstance const &CI,
+                 std::vector<std::string> const &Args) override
+  {
+    for (auto const &Arg : Args) {
+      if (Options_.parse(Arg))
+        continue;
+
+      auto &Diags { CI.getDiagnostics() };
+
+      unsigned ID { Diags.getCustomDiagID(
+                      clang::DiagnosticsEngine::Error,
+                      "invalid argument '%0' for plugin 'fire'") };
+
+      Diags.Report(ID) << Arg;
+
+      return false;
+    }
+
+    if (Options_.Rewrite && !Options_.Split.empty()) {
+      auto &Diags { CI.getDiagnostics() };
+
+      unsigned ID { Diags.getCustomDiagID(
+                      clang::DiagnosticsEngine::Error,
+                      "plugin 'fire' arguments 'rewrite' and 'split' are incompatible") };
+
+      Diags.Report(ID);
+
+      return false;
+    }
+
+    Stats_.Print = Options_.Stats;
+    Stats_.TimeTrace = Options_.TimeTrace;
+
+    return true;
+  }
+
+  clang::PluginASTAction::ActionType getActionType() override
+  {
+    return clang::PluginASTAction::ReplaceAction;
+  }
+
+  void EndSourceFileAction() override
+  {
+    if (Options_.Rewrite && FileHasFireCall_ && !FileRewriteError_)
+      compileRewrittenFile();
+
+    if (SplitThread_.joinable())
+      finishSplitGlue();
+
+    if (!Completion_.empty())
+      writeCompletion();
+
+    if (Stats_.Print)
+      Stats_.print(llvm::errs(), getCurrentFile());
+  }
+
+private:
+  void compileRewrittenFile()
+  {
+    std::string FileContent;
+
+    if (auto FileRewriteBuffer { FileRewriter_.getRewriteBufferFor(FileID_) }) {
+      FileContent.assign(FileRewriteBuffer->begin(), FileRewriteBuffer->end());
+    } else {
+      // The file mentions fire_llvm but does not contain a fire call, it
+      // still has to be compiled.
+      auto &SourceManager { CI_->getSourceManager() };
+
+      FileContent = SourceManager.getBufferData(SourceManager.getMainFileID()).str();
+    }
+
+    std::string PreambleCacheDir { Options_.Preamble ? Options_.CacheDir : "" };
+
+    if (!Options_.Cache || Options_.CacheDir.empty()) {
+      stats::Scope Scope(&Stats_, stats::Compile);
+
+      if (!compile(CI_,
+                   FileName_,
+                   FileContent.begin(),
+                   FileContent.end(),
+                   PreambleCacheDir))
+        reportCompileError();
+
+      return;
+    }
+
+    auto Output { CI_->createDefaultOutputFile(true, FileName_, "o") };
+    if (!Output)
+      return;
+
+    // Short-circuit the second pass if the object file is already cached.
+    std::string Key;
+    std::unique_ptr<llvm::MemoryBuffer> CachedObject;
+
+    {
+      stats::Scope Scope(&Stats_, stats::CacheLookup);
+
+      Key = cache::key(*CI_, FileContent);
+      CachedObject = cache::load(Options_.CacheDir, Key);
+    }
+
+    if (CachedObject) {
+      stats::count(&Stats_, stats::CacheHits);
+
+      *Output << CachedObject->getBuffer();
+      return;
+    }
+
+    stats::count(&Stats_, stats::CacheMisses);
+
+    llvm::SmallVector<char, 0> Object;
+
+    {
+      stats::Scope Scope(&Stats_, stats::Compile);
+
+      if (!compile(CI_,
+                   FileName_,
+                   FileContent.begin(),
+                   FileContent.end(),
+                   PreambleCacheDir,
+                   &Object)) {
+        reportCompileError();
+        return;
+      }
+    }
+
+    llvm::StringRef ObjectRef { Object.data(), Object.size() };
+
+    *Output << ObjectRef;
+
+    cache::store(Options_.CacheDir, Key, ObjectRef);
+  }
+
+  std::unique_ptr<clang::ASTConsumer> CreateSemaConsumer(
+    clang::CompilerInstance &CI,
+    llvm::StringRef FileName)
+  {
+    auto &Preprocessor { CI.getPreprocessor() };
+
+    Preprocessor.AddPragmaHandler(new FireGluePragmaHandler(&Glue_));
+
+    bool Cache { Options_.Cache && !Options_.CacheDir.empty() };
+
+    // When caching, the object file is written to memory first and only then
+    // copied to the actual output file.
+    std::unique_ptr<llvm::raw_pwrite_stream> Output;
+
+    if (Cache) {
+      Output = CI.createDefaultOutputFile(true, FileName, "o");
+      if (!Output)
+        return nullptr;
+
+      CI.setOutputStream(std::make_unique<llvm::raw_svector_ostream>(Object_));
+    }
+
+    // Generate code in the same pass instead of recompiling afterwards.
+    auto EmitObjConsumer { CreateEmitObjConsumer(CI, FileName) };
+    if (!EmitObjConsumer)
+      return nullptr;
+
+    if (Cache) {
+      EmitObjConsumer = std::make_unique<FireCacheConsumer>(
+        CI, std::move(EmitObjConsumer), &Glue_, &Object_, std::move(Output),
+        Options_.CacheDir, &Stats_);
+    }
+
+    std::string *SplitGlue { nullptr };
+    std::function<void()> SplitGlueReady;
+
+    if (!Options_.Split.empty()) {
+      SplitGlue = &SplitGlue_;
+      SplitGlueReady = [this, &CI]() { startSplitGlue(CI); };
+    }
+
+    std::vector<std::unique_ptr<clang::ASTConsumer>> Consumers;
+    Consumers.push_back(std::make_unique<FireSemaConsumer>(
+      &Glue_, SplitGlue, std::move(SplitGlueReady), completionIndex(), &Stats_));
+    Consumers.push_back(std::move(EmitObjConsumer));
+
+    return std::make_unique<clang::MultiplexConsumer>(std::move(Consumers));
+  }
+
+  std::unique_ptr<clang::ASTConsumer> CreateEmitObjConsumer(
+    clang::CompilerInstance &CI,
+    llvm::StringRef FileName)
+  {
+    EmitObj_.setCompilerInstance(&CI);
+    EmitObj_.setCurrentInput(getCurrentInput());
+
+    return EmitObj_.CreateASTConsumer(CI, FileName);
+  }
+
+  // Compiles the split glue while the user's translation unit is still
+  // being parsed and compiled, unless its object file is up to date.
+  void startSplitGlue(clang::CompilerInstance &CI)
+  {
+    CI_ = &CI;
+
+    {
+      stats::Scope Scope(&Stats_, stats::CacheLookup);
+
+      SplitKey_ = split::key(CI, SplitGlue_);
+
+      if (split::upToDate(Options_.Split, SplitKey_)) {
+        stats::count(&Stats_, stats::CacheHits);
+        return;
+      }
+    }
+
+    stats::count(&Stats_, stats::CacheMisses);
+
+    auto CInv { split::invocation(CI, split::sourcePath(Options_.Split)) };
+    if (!CInv) {
+      reportSplitGlueError("failed to compile glue translation unit '%0'");
+      return;
+    }
+
+    SplitThread_ = std::thread([this, CInv]() {
+      SplitResult_ = split::compile(CInv, SplitGlue_, SplitObject_);
+    });
+  }
+
+  void finishSplitGlue()
+  {
+    {
+      stats::Scope Scope(&Stats_, stats::Compile);
+
+      SplitThread_.join();
+    }
+
+    if (!SplitResult_.Success) {
+      llvm::errs() << SplitResult_.Errors;
+
+      reportSplitGlueError("failed to compile glue translation unit '%0'");
+      return;
+    }
+
+    llvm::StringRef Object { SplitObject_.data(), SplitObject_.size() };
+
+    if (!split::store(Options_.Split, SplitKey_, SplitResult_, Object))
+      reportSplitGlueError("failed to write glue object file '%0'");
+  }
+
+  completion::Index *completionIndex()
+  { return Options_.Completion.empty() ? nullptr : &Completion_; }
+
+  void writeCompletion() const
+  {
+    if (completion::write(Options_.Completion, Completion_))
+      return;
+
+    auto &Diags { getCompilerInstance().getDiagnostics() };
+
+    unsigned ID { Diags.getCustomDiagID(
+                    clang::DiagnosticsEngine::Error,
+                    "failed to write completion index '%0'") };
+
+    Diags.Report(ID) << Options_.Completion;
+  }
+
+  void reportSplitGlueError(char const *Message) const
+  {
+    auto &Diags { CI_->getDiagnostics() };
+
+    unsigned ID { Diags.getCustomDiagID(clang::DiagnosticsEngine::Error, Message) };
+
+    Diags.Report(ID) << Options_.Split;
+  }
+
+  void reportCompileError() const
+  {
+    auto &Diags { CI_->getDiagnostics() };
+
+    unsigned ID { Diags.getCustomDiagID(
+                    clang::DiagnosticsEngine::Error,
+                    "failed to compile rewritten file '%0'") };
+
+    Diags.Report(ID) << FileName_;
+  }
+
+  options::Options Options_;
+  stats::Stats Stats_;
+
+  bool FileHasFireCall_ = true;
+
+  std::string Glue_;
+  std::string SplitGlue_;
+  std::string SplitKey_;
+  std::thread SplitThread_;
+  split::Result SplitResult_;
+  llvm::SmallVector<char, 0> SplitObject_;
+  completion::Index Completion_;
+  FireEmitObjAction EmitObj_;
+  llvm::SmallVector<char, 0> Object_;
+
   clang::CompilerInstance *CI_;
 
   std::string FileName_;
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <string>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Path.h"
+
+namespace options {
+
+inline std::string defaultCacheDir()
+{
+  llvm::SmallString<128> CacheDir;
+  if (!llvm::sys::path::cache_directory(CacheDir))
+    return "";
+
+  llvm::sys::path::append(CacheDir, "fire-llvm");
+
+  return CacheDir.str().str();
+}
+
+struct Options
+{
+  // Rewrite 'main' textually and compile the rewritten file a second time.
+  bool Rewrite = false;
+
+  // Cache precompiled preambles for the second compilation pass on disk.
+  bool Preamble = false;
+
+  // Cache generated object files on disk.
+  bool Cache = false;
+
+  // Location of on-disk caches, caching is disabled if this is empty.
+  std::string CacheDir = defaultCacheDir();
+
+  // Compile the glue into a translation unit of its own, written to this
+  // object file, instead of injecting it into the user's translation unit.
+  std::string Split;
+
+  // Write a shell completion index and scripts for the program named after
+  // the last component of this path prefix.
+  std::string Completion;
+
+  // Print phase timings and counters.
+  bool Stats = false;
+
+  // Add plugin phases to -ftime-trace output.
+  bool TimeTrace = false;
+
+  bool parse(llvm::StringRef Arg)
+  {
+    if (Arg == "rewrite") {
+      Rewrite = true;
+    } else if (Arg == "cache") {
+      Cache = true;
+    } else if (Arg == "preamble") {
+      Preamble = true;
+    } else if (Arg.consume_front("cache-dir=")) {
+      CacheDir = Arg.str();
+    } else if (Arg.consume_front("split=")) {
+      Split = Arg.str();
+    } else if (Arg.consume_front("completion=")) {
+      Completion = Arg.str();
+    } else if (Arg == "stats") {
+      Stats = true;
+    } else if (Arg == "time-trace") {
+      TimeTrace = true;
+    } else {
+      return false;
+    }
+
+    return true;
+  }
+};
+
+} // end namespace options
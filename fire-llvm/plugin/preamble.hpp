@@ -0,0 +1,212 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <system_error>
+
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Basic/Version.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/CompilerInvocation.h"
+#include "clang/Frontend/FrontendActions.h"
+#include "clang/Lex/Lexer.h"
+#include "clang/Lex/PreprocessorOptions.h"
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Chrono.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "file.hpp"
+
+namespace preamble {
+
+inline std::string key(llvm::StringRef Preamble,
+                       llvm::ArrayRef<char const *> CommandLineArgs)
+{
+  llvm::MD5 Hash;
+
+  Hash.update(clang::getClangFullVersion());
+
+  for (auto Arg : CommandLineArgs) {
+    Hash.update(Arg);
+    Hash.update(llvm::StringRef("\0", 1));
+  }
+
+  Hash.update(Preamble);
+
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+
+  return Result.digest().str().str();
+}
+
+// Dependency files list every file that went into a cached preamble as
+// "<size> <modification time> <path>" lines.
+
+inline bool dependenciesUnchanged(llvm::StringRef DepsPath)
+{
+  auto DepsBuffer { llvm::MemoryBuffer::getFile(DepsPath) };
+  if (!DepsBuffer)
+    return false;
+
+  llvm::SmallVector<llvm::StringRef, 64> Deps;
+  (*DepsBuffer)->getBuffer().split(Deps, '\n', -1, false);
+
+  for (auto Dep : Deps) {
+    auto [DepSize, DepRest] = Dep.split(' ');
+    auto [DepTime, DepPath] = DepRest.split(' ');
+
+    std::uint64_t Size;
+    std::int64_t Time;
+    if (DepSize.getAsInteger(10, Size) || DepTime.getAsInteger(10, Time))
+      return false;
+
+    llvm::sys::fs::file_status Status;
+    if (llvm::sys::fs::status(DepPath, Status))
+      return false;
+
+    if (Status.getSize() != Size ||
+        llvm::sys::toTimeT(Status.getLastModificationTime()) != Time)
+      return false;
+  }
+
+  return true;
+}
+
+inline bool writeDependencies(clang::SourceManager const &SourceManager,
+                              llvm::StringRef DepsPath)
+{
+  std::string Deps;
+  llvm::raw_string_ostream DepsStream(Deps);
+
+  auto MainFile { SourceManager.getFileEntryForID(SourceManager.getMainFileID()) };
+
+  for (auto It { SourceManager.fileinfo_begin() };
+       It != SourceManager.fileinfo_end();
+       ++It) {
+    auto File { It->first };
+    if (File == MainFile)
+      continue;
+
+    DepsStream << File->getSize() << " "
+               << static_cast<std::int64_t>(File->getModificationTime()) << " "
+               << File->getName() << "\n";
+  }
+
+  return file::writeAtomically(DepsPath, DepsStream.str());
+}
+
+inline bool build(clang::CompilerInstance *CI,
+                  std::string const &FileName,
+                  llvm::StringRef Preamble,
+                  llvm::StringRef PCHPath,
+                  llvm::StringRef DepsPath)
+{
+  auto &CodeGenOpts { CI->getCodeGenOpts() };
+  auto &Diagnostics { CI->getDiagnostics() };
+
+  llvm::SmallString<128> PCHTmpPath;
+  if (!file::temporaryPath(PCHPath, PCHTmpPath))
+    return false;
+
+  // create preamble compiler instance
+  auto CInvPreamble { std::make_shared<clang::CompilerInvocation>() };
+
+  if (!clang::CompilerInvocation::CreateFromArgs(
+        *CInvPreamble, CodeGenOpts.CommandLineArgs, Diagnostics))
+    return false;
+
+  auto &FrontendOpts { CInvPreamble->getFrontendOpts() };
+  FrontendOpts.ProgramAction = clang::frontend::GeneratePCH;
+  FrontendOpts.OutputFile = PCHTmpPath.str().str();
+
+  auto &PreprocessorOpts { CInvPreamble->getPreprocessorOpts() };
+  PreprocessorOpts.PrecompiledPreambleBytes = { 0, false };
+  PreprocessorOpts.GeneratePreamble = true;
+
+  // only the preamble is compiled
+  auto PreambleBuffer { llvm::MemoryBuffer::getMemBufferCopy(Preamble, FileName) };
+  PreprocessorOpts.addRemappedFile(FileName, PreambleBuffer.release());
+
+  CInvPreamble->getDependencyOutputOpts() = clang::DependencyOutputOptions();
+
+  clang::CompilerInstance CIPreamble;
+  CIPreamble.setInvocation(CInvPreamble);
+
+  // a failure to build the preamble must not fail the compilation
+  CIPreamble.createDiagnostics(new clang::IgnoringDiagConsumer());
+
+  clang::GeneratePCHAction GeneratePCH;
+
+  if (!CIPreamble.ExecuteAction(GeneratePCH) ||
+      CIPreamble.getDiagnostics().hasErrorOccurred()) {
+    llvm::sys::fs::remove(PCHTmpPath);
+    return false;
+  }
+
+  if (!file::replace(PCHTmpPath, PCHPath))
+    return false;
+
+  return writeDependencies(CIPreamble.getSourceManager(), DepsPath);
+}
+
+// Builds or reuses a cached precompiled preamble for the given file content
+// and configures the invocation to skip over it.
+inline bool use(clang::CompilerInstance *CI,
+                clang::CompilerInvocation &CInv,
+                std::string const &FileName,
+                std::string const &FileContent,
+                std::string const &CacheDir)
+{
+  auto &PreprocessorOpts { CInv.getPreprocessorOpts() };
+
+  if (CacheDir.empty() || !PreprocessorOpts.ImplicitPCHInclude.empty())
+    return false;
+
+  auto Bounds { clang::Lexer::ComputePreamble(FileContent, CI->getLangOpts()) };
+  if (Bounds.Size == 0)
+    return false;
+
+  llvm::StringRef Preamble { FileContent.data(), Bounds.Size };
+
+  auto Key { key(Preamble, CI->getCodeGenOpts().CommandLineArgs) };
+
+  if (llvm::sys::fs::create_directories(CacheDir))
+    return false;
+
+  llvm::SmallString<128> PCHPath { CacheDir };
+  llvm::sys::path::append(PCHPath, Key + ".pch");
+
+  llvm::SmallString<128> DepsPath { CacheDir };
+  llvm::sys::path::append(DepsPath, Key + ".deps");
+
+  if (!llvm::sys::fs::exists(PCHPath) || !dependenciesUnchanged(DepsPath)) {
+    if (!build(CI, FileName, Preamble, PCHPath, DepsPath))
+      return false;
+  }
+
+  PreprocessorOpts.ImplicitPCHInclude = PCHPath.str().str();
+  PreprocessorOpts.PrecompiledPreambleBytes = { Bounds.Size,
+                                                Bounds.PreambleEndsAtStartOfLine };
+
+  // dependencies have already been validated above
+#if CLANG_VERSION_MAJOR >= 13
+  PreprocessorOpts.DisablePCHOrModuleValidation =
+    clang::DisableValidationForModuleKind::PCH;
+#else
+  PreprocessorOpts.DisablePCHValidation = true;
+#endif
+
+  return true;
+}
+
+} // end namespace preamble
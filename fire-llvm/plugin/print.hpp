@@ -3,10 +3,14 @@
 #include <string>
 
 #include "clang/AST/ASTContext.h"
+#include "clang/AST/Decl.h"
 #include "clang/AST/PrettyPrinter.h"
 #include "clang/AST/Type.h"
 #include "clang/Basic/SourceLocation.h"
 
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/raw_ostream.h"
+
 namespace print {
 
 inline std::string type(clang::ASTContext const &Context,
@@ -15,10 +19,27 @@ inline std::string type(clang::ASTContext const &Context,
   auto &LangOpts { Context.getLangOpts() };
 
   clang::PrintingPolicy PP { LangOpts };
+  PP.SuppressUnwrittenScope = true;
 
   return Type.getAsString(PP);
 }
 
+inline std::string name(clang::ASTContext const &Context,
+                        clang::NamedDecl const *Decl)
+{
+  auto &LangOpts { Context.getLangOpts() };
+
+  clang::PrintingPolicy PP { LangOpts };
+  PP.SuppressUnwrittenScope = true;
+
+  std::string Name;
+  llvm::raw_string_ostream NameStream { Name };
+
+  Decl->printQualifiedName(NameStream, PP);
+
+  return "::" + NameStream.str();
+}
+
 inline std::string source(clang::ASTContext const &Context,
                           clang::SourceRange const &Range)
 {
@@ -30,4 +51,17 @@ inline std::string source(clang::ASTContext const &Context,
   return std::string(Begin, End - Begin + 1);
 }
 
+// C++ string literal containing Str.
+inline std::string literal(llvm::StringRef Str)
+{
+  std::string Literal;
+  llvm::raw_string_ostream LiteralStream { Literal };
+
+  LiteralStream << '"';
+  LiteralStream.write_escaped(Str);
+  LiteralStream << '"';
+
+  return LiteralStream.str();
+}
+
 } // end namespace print
@@ -1,20 +1,19 @@
 #pragma once
 
-#include <string>
-#include <utility>
+#include <algorithm>
 #include <vector>
 
+#include "clang/AST/Decl.h"
 #include "clang/AST/DeclCXX.h"
 
 #include "llvm/Support/Casting.h"
 
 namespace record {
 
-std::pair<std::vector<clang::CXXMethodDecl const *>, std::string>
+inline std::vector<clang::CXXMethodDecl const *>
 publicMethods(clang::CXXRecordDecl const *Record)
 {
   std::vector<clang::CXXMethodDecl const *> publicMethods;
-  std::string publicMethodOptions;
 
   for (auto Method : Record->methods()) {
     // Skip non-public methods.
@@ -30,16 +29,72 @@ publicMethods(clang::CXXRecordDecl const *Record)
       continue;
 
     publicMethods.push_back(Method);
+  }
+
+  return publicMethods;
+}
+
+// Public constructors a fired class can be lazily constructed with, i.e.
+// excluding copy and move constructors.
+inline std::vector<clang::CXXConstructorDecl const *>
+publicConstructors(clang::CXXRecordDecl const *Record)
+{
+  std::vector<clang::CXXConstructorDecl const *> publicConstructors;
+
+  for (auto Constructor : Record->ctors()) {
+    if (Constructor->getAccess() != clang::AS_public ||
+        Constructor->isImplicit() ||
+        Constructor->isDeleted() ||
+        Constructor->isCopyOrMoveConstructor())
+      continue;
+
+    publicConstructors.push_back(Constructor);
+  }
 
-    auto MethodName { Method->getNameAsString() };
+  return publicConstructors;
+}
+
+// Public methods grouped by name, in order of declaration.
+inline std::vector<std::vector<clang::CXXMethodDecl const *>>
+publicMethodOverloads(clang::CXXRecordDecl const *Record)
+{
+  std::vector<std::vector<clang::CXXMethodDecl const *>> publicMethodOverloads;
 
-    if (publicMethodOptions.empty())
-      publicMethodOptions = MethodName;
+  for (auto Method : publicMethods(Record)) {
+    auto Overloads { std::find_if(publicMethodOverloads.begin(),
+                                  publicMethodOverloads.end(),
+                                  [Method](auto const &Overloads)
+                                  { return Overloads[0]->getDeclName() == Method->getDeclName(); }) };
+
+    if (Overloads == publicMethodOverloads.end())
+      publicMethodOverloads.push_back({ Method });
     else
-      publicMethodOptions += "|" + MethodName;
+      Overloads->push_back(Method);
+  }
+
+  return publicMethodOverloads;
+}
+
+// Public data members of (non-standard library) record type, fired classes
+// expose these as subcommands.
+inline std::vector<clang::FieldDecl const *>
+publicRecordFields(clang::CXXRecordDecl const *Record)
+{
+  std::vector<clang::FieldDecl const *> publicRecordFields;
+
+  for (auto Field : Record->fields()) {
+    if (Field->getAccess() != clang::AS_public || Field->getName().empty())
+      continue;
+
+    auto FieldRecord { Field->getType()->getAsCXXRecordDecl() };
+    if (!FieldRecord || !FieldRecord->hasDefinition() ||
+        FieldRecord->isInStdNamespace())
+      continue;
+
+    publicRecordFields.push_back(Field);
   }
 
-  return { publicMethods, publicMethodOptions };
+  return publicRecordFields;
 }
 
 } // end namespace record
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "clang/Basic/DiagnosticOptions.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Basic/Version.h"
+#include "clang/CodeGen/CodeGenAction.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/CompilerInvocation.h"
+#include "clang/Frontend/FrontendOptions.h"
+#include "clang/Frontend/TextDiagnosticPrinter.h"
+#include "clang/Lex/PreprocessorOptions.h"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Chrono.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "cache.hpp"
+#include "file.hpp"
+
+// The glue of a split translation unit only depends on the runtime and the
+// command line interface of the fired function or class. It is compiled into
+// an object file of its own which is only rebuilt if the interface changes.
+namespace split {
+
+// Complete source of the glue translation unit.
+inline std::string source(llvm::StringRef Glue)
+{
+  return "#include <array>\n"
+         "#include <cstdint>\n"
+         "#include <optional>\n"
+         "#include <string>\n"
+         "#include <string_view>\n"
+         "#include <utility>\n"
+         "#include <vector>\n"
+         "\n"
+         "#include <fire-llvm/fire.hpp>\n"
+         "\n" + Glue.str();
+}
+
+// Name under which the glue translation unit is compiled.
+inline std::string sourcePath(std::string const &ObjectPath)
+{ return ObjectPath + ".cpp"; }
+
+// Sidecar file recording the key of an object file and the files it was
+// compiled from.
+inline std::string keyPath(std::string const &ObjectPath)
+{ return ObjectPath + ".key"; }
+
+// Unlike cache::key, only covers the compiler, the command line and the glue
+// itself, not the contents of the user's translation unit.
+inline std::string key(clang::CompilerInstance &CI, llvm::StringRef Source)
+{
+  llvm::MD5 Hash;
+
+  Hash.update(clang::getClangFullVersion());
+  Hash.update(cache::pluginIdentity());
+
+  cache::commandLine(CI, Hash);
+
+  Hash.update(Source);
+
+  return cache::digest(Hash);
+}
+
+inline std::string fileStamp(llvm::StringRef FileName)
+{
+  llvm::sys::fs::file_status Status;
+  if (llvm::sys::fs::status(FileName, Status))
+    return "";
+
+  return llvm::formatv("{0} {1}",
+                       Status.getSize(),
+                       llvm::sys::toTimeT(Status.getLastModificationTime()));
+}
+
+// Whether the object file exists and was compiled from the same glue, with
+// none of the headers it includes having changed since.
+inline bool upToDate(std::string const &ObjectPath, std::string const &Key)
+{
+  if (!llvm::sys::fs::exists(ObjectPath))
+    return false;
+
+  auto KeyBuffer { llvm::MemoryBuffer::getFile(keyPath(ObjectPath)) };
+  if (!KeyBuffer)
+    return false;
+
+  llvm::SmallVector<llvm::StringRef, 64> Lines;
+  (*KeyBuffer)->getBuffer().split(Lines, '\n', -1, false);
+
+  if (Lines.empty() || Lines[0] != Key)
+    return false;
+
+  for (std::size_t i { 1 }; i + 1 < Lines.size(); i += 2) {
+    if (fileStamp(Lines[i]) != Lines[i + 1])
+      return false;
+  }
+
+  return true;
+}
+
+// Invocation compiling the glue with the same flags as the user's
+// translation unit. This has to be created on the thread that owns CI.
+inline std::shared_ptr<clang::CompilerInvocation> invocation(
+  clang::CompilerInstance &CI,
+  std::string const &SourcePath)
+{
+  auto CInv { std::make_shared<clang::CompilerInvocation>() };
+
+  if (!clang::CompilerInvocation::CreateFromArgs(
+        *CInv, CI.getCodeGenOpts().CommandLineArgs, CI.getDiagnostics()))
+    return nullptr;
+
+  // Do not load the plugin again and do not overwrite the dependency file
+  // of the user's translation unit.
+  auto &FrontendOpts { CInv->getFrontendOpts() };
+  FrontendOpts.Plugins.clear();
+  FrontendOpts.AddPluginActions.clear();
+  FrontendOpts.PluginArgs.clear();
+  FrontendOpts.Inputs.clear();
+  FrontendOpts.Inputs.emplace_back(SourcePath, clang::Language::CXX);
+
+  CInv->getDependencyOutputOpts() = clang::DependencyOutputOptions();
+
+  return CInv;
+}
+
+struct Result
+{
+  bool Success = false;
+
+  // Diagnostics emitted while compiling the glue.
+  std::string Errors;
+
+  // Files read while compiling the glue.
+  std::vector<std::string> Files;
+};
+
+// Compiles the glue source into Object. Only uses state owned by the given
+// invocation, so this can run concurrently with the user's translation unit.
+inline Result compile(std::shared_ptr<clang::CompilerInvocation> CInv,
+                      std::string const &Source,
+                      llvm::SmallVectorImpl<char> &Object)
+{
+  Result R;
+
+  llvm::raw_string_ostream ErrorStream { R.Errors };
+
+  auto SourcePath { CInv->getFrontendOpts().Inputs[0].getFile().str() };
+
+  clang::CompilerInstance CI;
+  CI.setInvocation(std::move(CInv));
+  CI.createDiagnostics(new clang::TextDiagnosticPrinter(
+                         ErrorStream, &CI.getDiagnosticOpts()));
+
+  CI.setOutputStream(std::make_unique<llvm::raw_svector_ostream>(Object));
+
+  auto SourceBuffer { llvm::MemoryBuffer::getMemBufferCopy(Source, SourcePath) };
+
+  // The preprocessor options take ownership of the buffer.
+  CI.getPreprocessorOpts().addRemappedFile(SourcePath, SourceBuffer.release());
+
+  clang::EmitObjAction EmitObj;
+  R.Success = CI.ExecuteAction(EmitObj) && !CI.getDiagnostics().hasErrorOccurred();
+
+  if (R.Success && CI.hasSourceManager()) {
+    auto &SourceManager { CI.getSourceManager() };
+
+    for (auto It { SourceManager.fileinfo_begin() };
+         It != SourceManager.fileinfo_end();
+         ++It) {
+      R.Files.push_back(It->first->getName().str());
+    }
+  }
+
+  ErrorStream.flush();
+
+  return R;
+}
+
+// Atomically replaces the object file and records its key, the key is only
+// written once the object file is in place.
+inline bool store(std::string const &ObjectPath,
+                  std::string const &Key,
+                  Result const &R,
+                  llvm::StringRef Object)
+{
+  llvm::sys::fs::remove(keyPath(ObjectPath));
+
+  if (!file::writeAtomically(ObjectPath, Object))
+    return false;
+
+  std::string KeyContent { Key + "\n" };
+
+  for (auto const &File : R.Files) {
+    // Remapped sources have no stamp, their content is part of the key.
+    auto Stamp { fileStamp(File) };
+    if (Stamp.empty())
+      continue;
+
+    KeyContent += File + "\n" + Stamp + "\n";
+  }
+
+  return file::writeAtomically(keyPath(ObjectPath), KeyContent);
+}
+
+} // end namespace split
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <string>
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace stats {
+
+enum Phase
+{
+  FindCall,
+  Glue,
+  CacheLookup,
+  Compile,
+  NumPhases
+};
+
+enum Counter
+{
+  Launchpads,
+  Params,
+  GlueBytes,
+  RewrittenBytes,
+  CacheHits,
+  CacheMisses,
+  NumCounters
+};
+
+inline llvm::StringRef phaseName(Phase P)
+{
+  switch (P) {
+  case FindCall:
+    return "fire-llvm find call";
+  case Glue:
+    return "fire-llvm code generation";
+  case CacheLookup:
+    return "fire-llvm cache lookup";
+  case Compile:
+    return "fire-llvm compile";
+  default:
+    return "";
+  }
+}
+
+inline llvm::StringRef counterName(Counter C)
+{
+  switch (C) {
+  case Launchpads:
+    return "launchpads emitted";
+  case Params:
+    return "parameters bound";
+  case GlueBytes:
+    return "bytes of glue generated";
+  case RewrittenBytes:
+    return "bytes rewritten";
+  case CacheHits:
+    return "object cache hits";
+  case CacheMisses:
+    return "object cache misses";
+  default:
+    return "";
+  }
+}
+
+struct Stats
+{
+  // Print phase timings and counters after every translation unit.
+  bool Print = false;
+
+  // Add phase spans to clang's -ftime-trace output.
+  bool TimeTrace = false;
+
+  std::array<std::chrono::steady_clock::duration, NumPhases> Times {};
+  std::array<std::size_t, NumCounters> Counters {};
+
+  void print(llvm::raw_ostream &OS, llvm::StringRef FileName) const
+  {
+    OS << "fire-llvm statistics for '" << FileName << "':\n";
+
+    for (std::size_t P { 0 }; P < NumPhases; ++P) {
+      std::chrono::duration<double, std::milli> Time { Times[P] };
+
+      OS << llvm::format("  %10.3f ms  ", Time.count())
+         << phaseName(static_cast<Phase>(P)) << "\n";
+    }
+
+    for (std::size_t C { 0 }; C < NumCounters; ++C) {
+      OS << llvm::format("  %13zu  ", Counters[C])
+         << counterName(static_cast<Counter>(C)) << "\n";
+    }
+  }
+};
+
+inline void count(Stats *S, Counter C, std::size_t N = 1)
+{
+  if (S)
+    S->Counters[C] += N;
+}
+
+// Times the enclosing scope as the given phase. S may be null.
+class Scope
+{
+public:
+  Scope(Stats *S, Phase P, llvm::StringRef Detail = "")
+  : S_(S),
+    P_(P),
+    Start_(std::chrono::steady_clock::now())
+  {
+    if (S_ && S_->TimeTrace)
+      TimeTraceScope_.emplace(phaseName(P_), Detail);
+  }
+
+  Scope(Scope const &) = delete;
+  Scope &operator=(Scope const &) = delete;
+
+  ~Scope()
+  {
+    if (S_)
+      S_->Times[P_] += std::chrono::steady_clock::now() - Start_;
+  }
+
+private:
+  Stats *S_;
+  Phase P_;
+  std::chrono::steady_clock::time_point Start_;
+  std::optional<llvm::TimeTraceScope> TimeTraceScope_;
+};
+
+} // end namespace stats
@@ -2,7 +2,11 @@
 
 #include <string>
 
+#include "clang/AST/ASTContext.h"
 #include "clang/AST/Decl.h"
+#include "clang/AST/DeclFriend.h"
+#include "clang/AST/DeclTemplate.h"
+#include "clang/AST/TemplateBase.h"
 #include "clang/AST/Type.h"
 
 #include "namespace.hpp"
@@ -46,4 +50,215 @@ inline bool isTemplate(clang::QualType Type,
   return TD->getName() == Name;
 }
 
+inline clang::QualType templateArgument(clang::QualType Type, unsigned Index)
+{
+  auto TS { Type->getAs<clang::TemplateSpecializationType>() };
+  if (!TS)
+    return clang::QualType();
+
+  auto Args { TS->template_arguments() };
+  if (Index >= Args.size() || Args[Index].getKind() != clang::TemplateArgument::Type)
+    return clang::QualType();
+
+  return Args[Index].getAsType();
+}
+
+// Name of the values accepted by a parameter of this type, as shown in usage
+// messages.
+inline std::string valueName(clang::QualType Type)
+{
+  if (isTemplate(Type, "optional", "std") ||
+      isTemplate(Type, "vector", "std") ||
+      isTemplate(Type, "span", "std")) {
+    auto Element { templateArgument(Type, 0) };
+    if (!Element.isNull())
+      return valueName(Element);
+  }
+
+  if (isTemplate(Type, "stream", "fire"))
+    return "file";
+
+  if (auto Enum { Type->getAs<clang::EnumType>() }) {
+    std::string Enumerators;
+
+    if (auto EnumDecl { Enum->getDecl()->getDefinition() }) {
+      for (auto Enumerator : EnumDecl->enumerators()) {
+        if (!Enumerators.empty())
+          Enumerators += "|";
+
+        Enumerators += Enumerator->getNameAsString();
+      }
+    }
+
+    return Enumerators;
+  }
+
+  if (is(Type, "basic_string") || is(Type, "basic_string_view"))
+    return "string";
+
+  // Types converted by a fire::parser specialization or fire_parse.
+  if (auto RD { Type->getAsCXXRecordDecl() })
+    return RD->getNameAsString();
+
+  if (Type->isBooleanType())
+    return "bool";
+
+  if (Type->isIntegerType())
+    return "int";
+
+  if (Type->isFloatingType())
+    return "float";
+
+  return "string";
+}
+
+// Whether a class type T is converted by a user-provided parser:
+// fire::parser<T> is explicitly specialized or fire_parse(std::string_view,
+// T &) is declared in T's namespace or as a friend of T, i.e. where argument
+// dependent lookup finds it.
+inline bool hasParser(clang::ASTContext &Context, clang::QualType Type)
+{
+  Type = Type.getCanonicalType().getUnqualifiedType();
+
+  auto TU { Context.getTranslationUnitDecl() };
+
+  for (auto FireDecl : TU->lookup(&Context.Idents.get("fire"))) {
+    auto Fire { llvm::dyn_cast<clang::NamespaceDecl>(FireDecl) };
+    if (!Fire)
+      continue;
+
+    for (auto ParserDecl : Fire->lookup(&Context.Idents.get("parser"))) {
+      auto Parser { llvm::dyn_cast<clang::ClassTemplateDecl>(ParserDecl) };
+      if (!Parser)
+        continue;
+
+      for (auto Specialization : Parser->specializations()) {
+        auto const &Args { Specialization->getTemplateArgs() };
+
+        if (Specialization->isExplicitSpecialization() &&
+            Args.size() == 1 &&
+            Args[0].getKind() == clang::TemplateArgument::Type &&
+            Context.hasSameType(Args[0].getAsType(), Type))
+          return true;
+      }
+    }
+  }
+
+  // Function templates only count if their result parameter can be deduced
+  // from T, i.e. it refers to T, to a template parameter or to another
+  // specialization of T's class template.
+  auto IsResult = [&Context, &Type](clang::QualType Result)
+  {
+    if (!Result->isLValueReferenceType())
+      return false;
+
+    Result = Result.getNonReferenceType();
+    if (Result.isConstQualified())
+      return false;
+
+    if (!Result->isDependentType())
+      return Context.hasSameType(Result, Type);
+
+    if (Result->getAs<clang::TemplateTypeParmType>())
+      return true;
+
+    auto Pattern { Result->getAs<clang::TemplateSpecializationType>() };
+    if (!Pattern)
+      return false;
+
+    auto Specialization {
+      llvm::dyn_cast_or_null<clang::ClassTemplateSpecializationDecl>(Type->getAsCXXRecordDecl()) };
+    if (!Specialization)
+      return false;
+
+    auto Template { Pattern->getTemplateName().getAsTemplateDecl() };
+
+    return Template &&
+           Template->getCanonicalDecl() ==
+           Specialization->getSpecializedTemplate()->getCanonicalDecl();
+  };
+
+  auto IsFireParse = [&IsResult](clang::NamedDecl const *Decl)
+  {
+    if (!Decl)
+      return false;
+
+    auto II { Decl->getIdentifier() };
+    if (!II || II->getName() != "fire_parse")
+      return false;
+
+    if (auto Template { llvm::dyn_cast<clang::FunctionTemplateDecl>(Decl) })
+      Decl = Template->getTemplatedDecl();
+
+    auto Function { llvm::dyn_cast<clang::FunctionDecl>(Decl) };
+    if (!Function || Function->getNumParams() != 2)
+      return false;
+
+    return IsResult(Function->getParamDecl(1)->getType());
+  };
+
+  auto RD { Type->getAsCXXRecordDecl() };
+  if (!RD)
+    return false;
+
+  if (RD->hasDefinition()) {
+    for (auto Friend : RD->getDefinition()->friends()) {
+      if (IsFireParse(Friend->getFriendDecl()))
+        return true;
+    }
+  }
+
+  auto Namespace { RD->getDeclContext()->getEnclosingNamespaceContext() };
+
+  for (auto Decl : Namespace->lookup(&Context.Idents.get("fire_parse"))) {
+    if (IsFireParse(Decl))
+      return true;
+  }
+
+  return false;
+}
+
+// Whether a type can be named without any of the user's declarations, i.e. it
+// is built in or only made up of types from the standard library and the
+// fire-llvm runtime.
+inline bool isStandalone(clang::QualType Type)
+{
+  Type = Type.getNonReferenceType().getCanonicalType();
+
+  if (Type->isBuiltinType())
+    return true;
+
+  if (auto P { Type->getAs<clang::PointerType>() })
+    return isStandalone(P->getPointeeType());
+
+  auto RD { Type->getAsCXXRecordDecl() };
+  if (!RD)
+    return false;
+
+  // Outermost enclosing namespace, skipping e.g. inline ABI namespaces.
+  clang::NamespaceDecl const *Outermost { nullptr };
+  for (auto DC { RD->getDeclContext() }; DC; DC = DC->getParent()) {
+    if (auto ND { llvm::dyn_cast<clang::NamespaceDecl>(DC) })
+      Outermost = ND;
+  }
+
+  if (!Outermost || !Outermost->getIdentifier())
+    return false;
+
+  auto Namespace { Outermost->getName() };
+  if (Namespace != "std" && Namespace != "fire")
+    return false;
+
+  auto TS { llvm::dyn_cast<clang::ClassTemplateSpecializationDecl>(RD) };
+  if (!TS)
+    return true;
+
+  for (auto const &Arg : TS->getTemplateArgs().asArray()) {
+    if (Arg.getKind() == clang::TemplateArgument::Type && !isStandalone(Arg.getAsType()))
+      return false;
+  }
+
+  return true;
+}
+
 } // end namespace type
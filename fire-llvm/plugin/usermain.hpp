@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "clang/AST/Decl.h"
+#include "clang/AST/PrettyPrinter.h"
+#include "clang/Basic/LangOptions.h"
+#include "clang/Basic/SourceLocation.h"
+#include "clang/Basic/TokenKinds.h"
+#include "clang/Lex/Lexer.h"
+#include "clang/Lex/Token.h"
+
+#include "llvm/ADT/StringRef.h"
+
+// In Sema mode, the glue defines 'main' itself. The user's definition is
+// renamed in the main file's buffer before parsing, so it is compiled as an
+// ordinary (never called) function.
+namespace usermain {
+
+constexpr char const *Name { "__fire_user_main" };
+
+// The renamed function has no implicit 'return 0', it is added explicitly.
+// Silence the warnings the renamed function would otherwise cause. All
+// additions are made on the lines they concern, so source locations of all
+// other lines are unaffected.
+constexpr char const *Push {
+  "_Pragma(\"clang diagnostic push\") "
+  "_Pragma(\"clang diagnostic ignored \\\"-Wmissing-prototypes\\\"\") "
+  "_Pragma(\"clang diagnostic ignored \\\"-Wunreachable-code-return\\\"\") "
+};
+
+constexpr char const *Return { " return 0; " };
+
+constexpr char const *Pop { " _Pragma(\"clang diagnostic pop\")" };
+
+inline bool is(clang::FunctionDecl const *Function)
+{
+  auto II { Function->getIdentifier() };
+
+  return II && II->getName() == Name;
+}
+
+// Renames the first definition of 'main' at file scope. Returns an empty
+// string if there is none.
+inline std::string rename(llvm::StringRef Source, clang::LangOptions const &LangOpts)
+{
+  clang::Lexer Lex(clang::SourceLocation(), LangOpts,
+                   Source.begin(), Source.begin(), Source.end());
+
+  clang::Token Tok;
+
+  auto Next = [&Lex, &Tok]()
+  { return !Lex.LexFromRawLexer(Tok) || Tok.isNot(clang::tok::eof); };
+
+  auto Offset = [&Lex, &Tok, &Source]() -> std::size_t
+  { return Lex.getBufferLocation() - Source.begin() - Tok.getLength(); };
+
+  auto IsMain = [&Tok]()
+  {
+    return Tok.is(clang::tok::raw_identifier) && Tok.getRawIdentifier() == "main";
+  };
+
+  unsigned Depth { 0 };
+  bool AfterMember { false };
+
+  bool Valid { Next() };
+
+  while (Valid) {
+    // Skip preprocessor directives.
+    if (Tok.is(clang::tok::hash) && Tok.isAtStartOfLine()) {
+      while ((Valid = Next()) && !Tok.isAtStartOfLine())
+        ;
+      continue;
+    }
+
+    if (Tok.is(clang::tok::l_brace)) {
+      ++Depth;
+    } else if (Tok.is(clang::tok::r_brace)) {
+      if (Depth > 0)
+        --Depth;
+    } else if (Depth == 0 && !AfterMember && IsMain()) {
+      auto NameOffset { Offset() };
+
+      if (!(Valid = Next()) || Tok.isNot(clang::tok::l_paren))
+        continue;
+
+      // Parameter list, then either a declaration or the body.
+      unsigned Parens { 0 };
+      bool Definition { false };
+
+      do {
+        if (Tok.is(clang::tok::l_paren)) {
+          ++Parens;
+        } else if (Tok.is(clang::tok::r_paren)) {
+          --Parens;
+        } else if (Parens == 0 && Tok.is(clang::tok::semi)) {
+          break;
+        } else if (Parens == 0 && Tok.is(clang::tok::l_brace)) {
+          Definition = true;
+          break;
+        }
+      } while ((Valid = Next()));
+
+      if (!Definition)
+        continue;
+
+      unsigned Braces { 0 };
+
+      do {
+        if (Tok.is(clang::tok::l_brace)) {
+          ++Braces;
+        } else if (Tok.is(clang::tok::r_brace) && --Braces == 0) {
+          auto CloseOffset { Offset() };
+
+          return Source.substr(0, NameOffset).str() + Push + Name +
+                 Source.substr(NameOffset + 4, CloseOffset - NameOffset - 4).str() +
+                 Return + "}" + Pop +
+                 Source.substr(CloseOffset + 1).str();
+        }
+      } while (Next());
+
+      return "";
+    }
+
+    AfterMember = Tok.isOneOf(clang::tok::period,
+                              clang::tok::arrow,
+                              clang::tok::coloncolon);
+
+    Valid = Next();
+  }
+
+  return "";
+}
+
+// Definition of 'main' calling the renamed function, for main files that
+// mention fire_llvm without calling it. They must behave as if the plugin was
+// not loaded.
+inline std::string forward(clang::FunctionDecl const *Function,
+                           clang::PrintingPolicy const &Policy)
+{
+  std::string Params;
+  std::string Args;
+
+  for (unsigned I { 0 }; I < Function->getNumParams(); ++I) {
+    auto Arg { "fire_arg" + std::to_string(I) };
+
+    if (I > 0) {
+      Params += ", ";
+      Args += ", ";
+    }
+
+    Params += Function->getParamDecl(I)->getType().getAsString(Policy) + " " + Arg;
+    Args += Arg;
+  }
+
+  return "int main(" + Params + ")\n{ return ::" + std::string(Name) + "(" + Args + "); }\n";
+}
+
+} // end namespace usermain
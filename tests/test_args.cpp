@@ -0,0 +1,27 @@
+#include <fire-llvm/fire.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+void fire_main_args(int n, std::vector<std::string> const &rest)
+{
+  std::cout << "n = " << n << ", rest = {";
+
+  if (!rest.empty()) {
+    std::cout << rest[0];
+    for (std::size_t i = 1; i < rest.size(); ++i)
+      std::cout << ", " << rest[i];
+  }
+
+  std::cout << "}";
+}
+
+}
+
+int main()
+{
+  fire::fire_llvm(fire_main_args);
+}
@@ -0,0 +1,36 @@
+#include <fire-llvm/fire.hpp>
+
+#include <future>
+#include <utility>
+#include <vector>
+
+struct Jobs
+{
+  std::future<int> square(int x)
+  {
+    return fire::async([x]() { return x * x; });
+  }
+
+  std::future<int> sum_squares(std::vector<int> const &values)
+  {
+    std::vector<std::future<int>> squares;
+    for (auto value : values)
+      squares.push_back(square(value));
+
+    return std::async(std::launch::deferred,
+                      [squares = std::move(squares)]() mutable {
+                        int sum = 0;
+                        for (auto &square : squares)
+                          sum += square.get();
+
+                        return sum;
+                      });
+  }
+};
+
+Jobs jobs;
+
+int main()
+{
+  fire::fire_llvm(jobs);
+}
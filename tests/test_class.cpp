@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <optional>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -17,6 +18,14 @@ struct S
     return a + b;
   }
 
+  int divide(int a, int b)
+  {
+    if (b == 0)
+      throw std::domain_error("division by zero");
+
+    return a / b;
+  }
+
   bool flag(bool f)
   {
     return f;
@@ -0,0 +1,29 @@
+#include <fire-llvm/fire.hpp>
+
+#include <vector>
+
+struct Pipeline
+{
+  fire::task<int> square(int x)
+  {
+    co_await fire::schedule();
+
+    co_return x * x;
+  }
+
+  fire::task<int> sum_squares(std::vector<int> values)
+  {
+    int sum = 0;
+    for (auto value : values)
+      sum += co_await square(value);
+
+    co_return sum;
+  }
+};
+
+Pipeline pipeline;
+
+int main()
+{
+  fire::fire_llvm(pipeline);
+}
@@ -0,0 +1,23 @@
+#include <fire-llvm/fire.hpp>
+
+#include <optional>
+#include <vector>
+
+namespace {
+
+int fire_main_default_variadic(std::vector<int> values = {1, 2, 3},
+                               std::optional<int> scale = 2)
+{
+  int sum { 0 };
+  for (auto value : values)
+    sum += value;
+
+  return scale ? sum * *scale : sum;
+}
+
+}
+
+int main()
+{
+  fire::fire_llvm(fire_main_default_variadic);
+}
@@ -0,0 +1,44 @@
+#include <fire-llvm/fire.hpp>
+
+#include <optional>
+#include <string>
+
+namespace {
+
+enum class Color { red, green, blue };
+
+enum Size { small, large };
+
+std::string name(Color color)
+{
+  switch (color) {
+  case Color::red:
+    return "red";
+  case Color::green:
+    return "green";
+  case Color::blue:
+    return "blue";
+  }
+
+  return "";
+}
+
+/// \param color fill color
+std::string fire_main_enum(Color color,
+                           Size size = large,
+                           std::optional<Color> border = std::nullopt)
+{
+  std::string result { name(color) + (size == small ? " small" : " large") };
+
+  if (border)
+    result += " " + name(*border);
+
+  return result;
+}
+
+}
+
+int main()
+{
+  fire::fire_llvm(fire_main_enum);
+}
@@ -0,0 +1,33 @@
+#include <fire-llvm/fire.hpp>
+
+#include <iostream>
+#include <string>
+
+class Index
+{
+public:
+  /// \param path location of the index
+  explicit Index(std::string const &path = "default.idx")
+  : path_(path)
+  {
+    std::cout << "loading " << path_ << std::endl;
+  }
+
+  std::string location()
+  {
+    return path_;
+  }
+
+  int count(int n)
+  {
+    return n;
+  }
+
+private:
+  std::string path_;
+};
+
+int main()
+{
+  fire::fire_llvm<Index>();
+}
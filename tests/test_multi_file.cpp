@@ -0,0 +1,10 @@
+#include <fire-llvm/fire.hpp>
+
+// Defined in multi_file/twice.cpp, which does not call fire::fire_llvm but is
+// compiled with the plugin nonetheless.
+int twice(int x);
+
+int main()
+{
+  fire::fire_llvm(twice);
+}
@@ -5,7 +5,6 @@
 
 namespace {
 
-// XXX make fire::optional implement complete std::optional interface
 void fire_main_optional(std::optional<int> opt)
 {
   if (opt)
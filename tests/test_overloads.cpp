@@ -0,0 +1,50 @@
+#include <fire-llvm/fire.hpp>
+
+#include <string>
+#include <vector>
+
+struct Shapes
+{
+  int area(int side)
+  {
+    return side * side;
+  }
+
+  int area(int width, int height)
+  {
+    return width * height;
+  }
+
+  std::string greet(std::string const &name)
+  {
+    return "hello " + name;
+  }
+
+  std::string greet(std::vector<std::string> const &names)
+  {
+    std::string greeting { "hello" };
+    for (auto const &name : names)
+      greeting += " " + name;
+
+    return greeting;
+  }
+
+  // Named like the symbols once generated for the methods above, they must
+  // not clash with the glue.
+  int area_0(int side)
+  {
+    return 4 * side;
+  }
+
+  std::string greet_help()
+  {
+    return "greet someone";
+  }
+};
+
+Shapes shapes;
+
+int main()
+{
+  fire::fire_llvm(shapes);
+}
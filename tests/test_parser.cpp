@@ -0,0 +1,111 @@
+#include <fire-llvm/fire.hpp>
+
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace net {
+
+struct address
+{
+  std::string host;
+  std::uint16_t port = 0;
+};
+
+// host:port
+bool fire_parse(std::string_view value, address &result)
+{
+  auto colon { value.rfind(':') };
+  if (colon == std::string_view::npos || colon == 0)
+    return false;
+
+  auto port { value.substr(colon + 1) };
+
+  auto [end, ec] = std::from_chars(port.data(), port.data() + port.size(), result.port);
+  if (ec != std::errc() || end != port.data() + port.size())
+    return false;
+
+  result.host = value.substr(0, colon);
+
+  return true;
+}
+
+template<typename T>
+struct range
+{
+  T first {};
+  T last {};
+};
+
+// first-last
+template<typename T>
+bool fire_parse(std::string_view value, range<T> &result)
+{
+  auto dash { value.find('-') };
+  if (dash == std::string_view::npos)
+    return false;
+
+  auto first { value.substr(0, dash) };
+  auto last { value.substr(dash + 1) };
+
+  auto [first_end, first_ec] = std::from_chars(first.data(), first.data() + first.size(), result.first);
+  if (first_ec != std::errc() || first_end != first.data() + first.size())
+    return false;
+
+  auto [last_end, last_ec] = std::from_chars(last.data(), last.data() + last.size(), result.last);
+
+  return last_ec == std::errc() && last_end == last.data() + last.size();
+}
+
+}
+
+namespace fire {
+
+// Milliseconds, with an optional "ms" suffix.
+template<>
+struct parser<std::chrono::milliseconds>
+{
+  static bool parse(std::string_view value, std::chrono::milliseconds &result)
+  {
+    if (value.size() > 2 && value.substr(value.size() - 2) == "ms")
+      value.remove_suffix(2);
+
+    std::chrono::milliseconds::rep count;
+
+    auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), count);
+    if (ec != std::errc() || end != value.data() + value.size())
+      return false;
+
+    result = std::chrono::milliseconds(count);
+
+    return true;
+  }
+};
+
+}
+
+namespace {
+
+/// \param addr server to connect to
+/// \param ports local ports to bind
+std::string fire_main_parser(net::address addr,
+                             std::optional<net::range<int>> ports,
+                             std::chrono::milliseconds timeout = std::chrono::milliseconds(100))
+{
+  auto result { addr.host + " " + std::to_string(addr.port) + " " + std::to_string(timeout.count()) };
+
+  if (ports)
+    result += " " + std::to_string(ports->first) + ".." + std::to_string(ports->last);
+
+  return result;
+}
+
+}
+
+int main()
+{
+  fire::fire_llvm(fire_main_parser);
+}
@@ -0,0 +1,19 @@
+#include <fire-llvm/fire.hpp>
+
+namespace {
+
+long fire_main_stream(fire::stream<long> in)
+{
+  long sum = 0;
+  for (auto i : in)
+    sum += i;
+
+  return sum;
+}
+
+}
+
+int main()
+{
+  fire::fire_llvm(fire_main_stream);
+}
@@ -0,0 +1,23 @@
+#include <fire-llvm/fire.hpp>
+
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+void fire_main_string_view(std::string_view msg,
+                           std::vector<std::string_view> const &words)
+{
+  std::cout << msg << ":";
+
+  for (auto word : words)
+    std::cout << " " << word;
+}
+
+}
+
+int main()
+{
+  fire::fire_llvm(fire_main_string_view);
+}
@@ -0,0 +1,72 @@
+#include <fire-llvm/fire.hpp>
+
+#include <string>
+
+struct Cache
+{
+  /// Drops all entries.
+  std::string flush()
+  {
+    return "cache flushed";
+  }
+
+  int size(int scale = 1)
+  {
+    return 42 * scale;
+  }
+};
+
+struct Database
+{
+  struct Index
+  {
+    std::string rebuild(std::string const &name)
+    {
+      return "rebuilt " + name;
+    }
+  };
+
+  std::string compact()
+  {
+    return "db compacted";
+  }
+
+  Index index;
+};
+
+// Not meant to be used from the command line, members of this type are
+// skipped with a warning.
+struct Mutex
+{
+  void lock(void *owner)
+  {
+    owner_ = owner;
+  }
+
+private:
+  void *owner_ = nullptr;
+};
+
+struct Service
+{
+  std::string status()
+  {
+    return "ok";
+  }
+
+  /// Cache maintenance.
+  Cache cache;
+
+  Database db;
+
+  Mutex mutex;
+
+  std::string name;
+};
+
+Service svc;
+
+int main()
+{
+  fire::fire_llvm(svc);
+}
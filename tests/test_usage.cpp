@@ -0,0 +1,19 @@
+#include <fire-llvm/fire.hpp>
+
+namespace {
+
+/// Scales a value.
+///
+/// \param value number to scale
+/// \param factor multiplier
+int fire_main_usage(int value, int factor = 2)
+{
+  return value * factor;
+}
+
+}
+
+int main()
+{
+  fire::fire_llvm(fire_main_usage);
+}